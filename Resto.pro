@@ -8,6 +8,7 @@ INCLUDEPATH += cpp/
 SOURCES += cpp/main.cpp \
     cpp/controller/controller.cpp \
     cpp/model/settings.cpp \
+    cpp/model/breakschedule.cpp \
     cpp/controller/settingscontroller.cpp \
     cpp/controller/timercontroller.cpp \
     cpp/workers/backupmanager.cpp \
@@ -15,7 +16,14 @@ SOURCES += cpp/main.cpp \
     cpp/workers/singleappmanager.cpp \
     cpp/workers/savemanager.cpp \
     cpp/utility/helpers.cpp \
-    cpp/controller/updatecontroller.cpp
+    cpp/controller/updatecontroller.cpp \
+    cpp/workers/scheduler.cpp \
+    cpp/workers/backupworker.cpp \
+    cpp/workers/updatedownloader.cpp \
+    cpp/utility/clock.cpp \
+    cpp/utility/checkpointjournal.cpp \
+    cpp/utility/livestatefile.cpp \
+    cpp/utility/virtualclock.cpp
 
 RESOURCES += qml.qrc
 
@@ -25,6 +33,9 @@ QML_IMPORT_PATH =
 HEADERS += \
     cpp/controller/controller.h \
     cpp/model/settings.h \
+    cpp/model/settingsschema.h \
+    cpp/model/breakrule.h \
+    cpp/model/breakschedule.h \
     cpp/controller/settingscontroller.h \
     cpp/controller/timercontroller.h \
     cpp/workers/backupmanager.h \
@@ -32,7 +43,15 @@ HEADERS += \
     cpp/workers/singleappmanager.h \
     cpp/workers/savemanager.h \
     cpp/utility/helpers.h \
-    cpp/controller/updatecontroller.h
+    cpp/controller/updatecontroller.h \
+    cpp/workers/scheduler.h \
+    cpp/workers/backupworker.h \
+    cpp/workers/updatedownloader.h \
+    cpp/utility/clock.h \
+    cpp/utility/checkpointjournal.h \
+    cpp/utility/livestatefile.h \
+    cpp/utility/virtualclock.h \
+    cpp/utility/thresholdmonitor.h
 
 include(orgInfo.pri)
 include(appInfo.pri)
@@ -27,18 +27,34 @@
 #include <QCoreApplication>
 #include <QCursor>
 
+const QList<Scheduler::Event> Controller::sc_events = {
+    Scheduler::Event::BreakStart,
+    Scheduler::Event::BreakEnd,
+    Scheduler::Event::WorkEnd
+};
+
 Controller::Controller()
-    : m_updateController(m_settingsController, QUrl(QString("http://%1").arg(APP_VERSION_URL)) ),
-      m_saveManager(m_backupManager)
+    : Controller(Clock::system())
+{}
+Controller::Controller(Clock &clock)
+    : m_timerController(clock),
+      m_updateController(m_settingsController, QUrl(QString("http://%1").arg(APP_VERSION_URL)), clock),
+      m_backupManager(clock),
+      m_saveManager(m_backupManager),
+      m_scheduler(clock)
 {
-    connect(&m_timerController, &TimerController::elapsedBreakDurationChanged, this, &Controller::onElapsedBreakDurationChange);
-    connect(&m_timerController, &TimerController::elapsedWorkPeriodChanged, this, &Controller::onElapsedWorkPeriodChange);
-    connect(&m_timerController, &TimerController::elapsedWorkTimeChanged, this, &Controller::onElapsedWorkTimeChange);
+    connect(&m_timerController, &TimerController::timeAdjusted, this, &Controller::onTimeAdjusted);
+    connect(&m_timerController, &TimerController::sleepDetected, this, &Controller::onSleepDetected);
+    connect(&m_timerController, &TimerController::snapshotChanged, this, &Controller::updateLiveState);
+
+    connect(&m_settingsController, &SettingsController::changed, this, &Controller::onSettingsChanged);
 
-    connect(&m_settingsController, &SettingsController::breakIntervalChanged, this, &Controller::onBreakIntervalChanged);
-    connect(&m_settingsController, &SettingsController::workTimeChanged, this, &Controller::onWorkTimeChanged);
+    connect(&m_scheduler, &Scheduler::triggered, this, &Controller::onScheduledEvent);
 
     connect(&m_backupManager, &BackupManager::backupData, this, &Controller::onBackupData);
+    connect(&m_backupManager, &BackupManager::aboutToBackup, this, &Controller::updateBackupData);
+
+    m_breakSchedule.setRules(settings().breakRules(), 0);
 
     m_saveManager.initialize(); // need to be done before backup manager
     m_backupManager.initialize();
@@ -87,6 +103,11 @@ bool Controller::isWorking() const
     return (m_state == State::Working);
 }
 
+int Controller::breakDuration()
+{
+    return ruleDuration(m_activeRule);
+}
+
 void Controller::save()
 {
     m_saveManager.save();
@@ -97,6 +118,21 @@ void Controller::clear()
     m_backupManager.cleanup();
 }
 
+bool Controller::saveSlot(const QString &name)
+{
+    return m_saveManager.save(name);
+}
+
+bool Controller::restoreSlot(const QString &name)
+{
+    return m_saveManager.restore(name);
+}
+
+bool Controller::restoreLatestSlot()
+{
+    return m_saveManager.restoreLatest();
+}
+
 QPoint Controller::cursorPos() const
 {
     // this is needed as a workaround for Ubuntu window move issue
@@ -116,10 +152,18 @@ void Controller::start()
     case State::Paused:
         startWork();
     case State::Recovered:
-        timer().start( (m_state == State::Off) ); // restart only from Off
+    {
+        const bool restart = (m_state == State::Off); // restart only from Off
+        timer().start(restart);
+        if (restart) // new work day for all rules
+        {
+            m_breakSchedule.reset(timer().elapsedWorkTimeMsecs());
+            updateSchedule();
+        }
         setState(State::Working);
         m_backupManager.start();
         break;
+    }
     default:
         qWarning() << "Start requested in unsupported state";
         break;
@@ -157,21 +201,32 @@ void Controller::stop()
 
 void Controller::startBreak()
 {
+    setActiveRule(m_pendingRule); // manual break is the main one
+    clearBreakRequest();
+
     timer().setElapsedBreakDuration(0);
     timer().countBreakTime();
 
     // update backup manager
     m_backupManager.data().elapsedWorkTime = 0;
+    m_backupManager.checkpoint();
 }
 void Controller::postponeBreak()
 {
-    m_postponeDuration += (timer().elapsedWorkPeriod() - m_lastRequestTime) + settings().postponeTime();
+    if (m_mainBreakRequested || !m_breakRequested)
+    {
+        m_postponeDuration += (timer().elapsedWorkPeriod() - m_lastRequestTime) + settings().postponeTime();
+    }
+    m_breakSchedule.postponeRequested(timer().elapsedWorkTimeMsecs()); // each rule by its own postpone time
+    clearBreakRequest();
+    updateSchedule();
 }
 void Controller::startWork()
 {
-    m_postponeDuration = m_lastRequestTime = 0;
-    timer().setElapsedWorkPeriod(0);
-    timer().countWorkTime();
+    // skipped break counts as taken, so it is not requested again
+    const auto rule = (timer().activePeriodType() == TimerController::PeriodType::Break) ? m_activeRule
+                                                                                          : m_pendingRule;
+    finishBreak(ruleDuration(rule));
 }
 
 void Controller::setState(Controller::State state)
@@ -193,9 +248,13 @@ void Controller::onBackupData(const BackupManager::Data &data)
         wasWorking = true;
     }
 
+    m_recovering = true; // recovered times are not crossings
     timer().setElapsedBreakDuration(0);
     timer().setElapsedWorkPeriod(data.elapsedWorkPeriod);
     timer().setElapsedWorkTime(data.elapsedWorkTime);
+    m_recovering = false;
+    resetThresholds();
+    m_breakSchedule.reset(timer().elapsedWorkTimeMsecs());
     if (data.elapsedWorkPeriod >= settings().breakInterval()) {
         postponeBreak();
     }
@@ -206,38 +265,256 @@ void Controller::onBackupData(const BackupManager::Data &data)
     }
 }
 
-void Controller::onElapsedBreakDurationChange(int elapsedBreakDuration)
+qint64 Controller::eventTarget(Scheduler::Event event)
 {
-    // check end of the break:
-    if (elapsedBreakDuration == settings().breakDuration()) // break has just ended
+    switch (event)
     {
-        emit breakEndRequest(); // inform about it
+    case Scheduler::Event::BreakStart:
+        return (settings().breakInterval() + m_postponeDuration) * 1000LL;
+    case Scheduler::Event::BreakEnd:
+        return ruleDuration(m_activeRule) * 1000LL;
+    case Scheduler::Event::WorkEnd:
+        return settings().workTime() * 1000LL;
+    default:
+        Q_ASSERT(false);
     }
+    return 0;
 }
 
-void Controller::onElapsedWorkPeriodChange(int elapsedWorkPeriod)
+qint64 Controller::eventElapsed(Scheduler::Event event)
 {
-    // check if break is needed:
-    if (elapsedWorkPeriod == settings().breakInterval() + m_postponeDuration) // break should be taken now
+    switch (event)
     {
-        m_lastRequestTime = elapsedWorkPeriod;
-        emit breakStartRequest(); // inform about it
+    case Scheduler::Event::BreakStart:
+        return timer().elapsedWorkPeriodMsecs();
+    case Scheduler::Event::BreakEnd:
+        return timer().elapsedBreakDurationMsecs();
+    case Scheduler::Event::WorkEnd:
+        return timer().elapsedWorkTimeMsecs();
+    default:
+        Q_ASSERT(false);
     }
+    return 0;
+}
 
-    // update backup manager
-    m_backupManager.data().elapsedWorkPeriod = elapsedWorkPeriod;
+TimerController::PeriodType Controller::eventPeriodType(Scheduler::Event event)
+{
+    return (event == Scheduler::Event::BreakEnd) ? TimerController::PeriodType::Break
+                                                 : TimerController::PeriodType::Work;
 }
 
-void Controller::onElapsedWorkTimeChange(int elapsedWorkTime)
+void Controller::updateSchedule()
 {
-    // check end of work:
-    if (elapsedWorkTime == settings().workTime()) // work should be finished now
+    m_scheduler.cancelAll();
+    if (!timer().isRunning())
+    {
+        return;
+    }
+
+    for (auto event : sc_events)
+    {
+        if (eventPeriodType(event) != timer().activePeriodType())
+        {
+            continue;
+        }
+
+        const auto remaining = eventTarget(event) - eventElapsed(event);
+        if (remaining > 0) // otherwise target has already passed
+        {
+            m_scheduler.schedule(event, remaining);
+        }
+    }
+
+    // deadlines passed without request are handled at once
+    const auto ruleDeadline = m_breakSchedule.nextDeadline();
+    if (timer().activePeriodType() == TimerController::PeriodType::Work && ruleDeadline >= 0)
     {
+        m_scheduler.schedule(Scheduler::Event::RuleBreakStart, ruleDeadline - timer().elapsedWorkTimeMsecs());
+    }
+}
+
+void Controller::checkThresholds()
+{
+    if (m_recovering)
+    {
+        return;
+    }
+
+    for (auto event : sc_events)
+    {
+        m_thresholds.setTarget(event, eventTarget(event));
+        if (m_thresholds.update(event, eventElapsed(event)) &&
+                eventPeriodType(event) == timer().activePeriodType())
+        {
+            handleEvent(event);
+        }
+    }
+
+    if (timer().activePeriodType() == TimerController::PeriodType::Work)
+    {
+        checkBreakRules();
+    }
+}
+
+void Controller::resetThresholds()
+{
+    for (auto event : sc_events)
+    {
+        m_thresholds.setTarget(event, eventTarget(event));
+        m_thresholds.reset(event, eventElapsed(event));
+    }
+}
+
+void Controller::handleEvent(Scheduler::Event event)
+{
+    switch (event)
+    {
+    case Scheduler::Event::BreakStart: // break should be taken now
+        m_lastRequestTime = timer().elapsedWorkPeriod();
+        m_mainBreakRequested = true;
+        requestBreak(BreakSchedule::sc_noRule); // inform about it
+        break;
+    case Scheduler::Event::BreakEnd: // break has just ended
+        emit breakEndRequest(); // inform about it
+        break;
+    case Scheduler::Event::WorkEnd: // work should be finished now
         emit workEndRequest(); // inform about it
+        break;
+    default:
+        Q_ASSERT(false);
     }
+}
 
-    // update backup manager
-    m_backupManager.data().elapsedWorkTime = elapsedWorkTime;
+int Controller::ruleDuration(int rule)
+{
+    return (rule == BreakSchedule::sc_noRule) ? settings().breakDuration()
+                                              : m_breakSchedule.rule(rule).duration;
+}
+
+void Controller::checkBreakRules()
+{
+    // deadlines are kept in a heap, so only passed ones are visited
+    const auto workTime = timer().elapsedWorkTimeMsecs();
+    while (m_breakSchedule.nextRule() != BreakSchedule::sc_noRule &&
+           m_breakSchedule.nextDeadline() <= workTime)
+    {
+        const auto rule = m_breakSchedule.nextRule();
+        m_breakSchedule.request(rule, workTime);
+        requestBreak(rule);
+    }
+}
+
+void Controller::requestBreak(int rule)
+{
+    if (!m_breakRequested || ruleDuration(rule) > ruleDuration(m_pendingRule))
+    {
+        m_pendingRule = rule;
+    }
+    m_breakRequested = true;
+    emit breakStartRequest();
+}
+
+void Controller::clearBreakRequest()
+{
+    m_breakRequested = m_mainBreakRequested = false;
+    m_pendingRule = BreakSchedule::sc_noRule;
+}
+
+void Controller::setActiveRule(int rule)
+{
+    if (m_activeRule == rule)
+    {
+        return;
+    }
+
+    m_activeRule = rule;
+    emit breakDurationChanged(breakDuration());
+}
+
+void Controller::finishBreak(int duration)
+{
+    m_breakSchedule.takeBreak(duration, timer().elapsedWorkTimeMsecs());
+    if (duration >= settings().breakDuration()) // main break is satisfied too
+    {
+        m_postponeDuration = m_lastRequestTime = 0;
+        timer().setElapsedWorkPeriod(0);
+    }
+
+    if (duration >= ruleDuration(m_pendingRule))
+    {
+        clearBreakRequest();
+    }
+    setActiveRule(BreakSchedule::sc_noRule);
+    timer().countWorkTime();
+}
+
+void Controller::onTimeAdjusted()
+{
+    checkThresholds();
+    updateSchedule();
+    m_backupManager.checkpoint(); // pause, period change or time correction
+}
+
+void Controller::onScheduledEvent()
+{
+    // a gap (e.g. system sleep) could change the state since event was scheduled
+    timer().synchronize();
+    checkThresholds();
+    updateSchedule(); // next rule deadline
+}
+
+void Controller::updateBackupData()
+{
+    const auto segment = timer().segment();
+    auto &liveData = m_backupManager.liveData();
+    liveData.breakDurationBase = segment.breakDurationBase;
+    liveData.workPeriodBase = segment.workPeriodBase;
+    liveData.workTimeBase = segment.workTimeBase;
+    liveData.segmentStart = segment.startWallTime;
+    liveData.countingWork = (segment.periodType == TimerController::PeriodType::Work);
+
+    // during break work times are not counted and stay as set by startBreak()
+    if (timer().activePeriodType() != TimerController::PeriodType::Work)
+    {
+        return;
+    }
+
+    m_backupManager.data().elapsedWorkPeriod = timer().elapsedWorkPeriod();
+    m_backupManager.data().elapsedWorkTime = timer().elapsedWorkTime();
+}
+
+void Controller::updateLiveState()
+{
+    updateBackupData();
+    m_backupManager.updateLiveState();
+}
+
+void Controller::onSettingsChanged(const Settings::Changes &changes)
+{
+    if (!Settings::contains<Setting::BreakRules, Setting::BreakInterval, Setting::WorkTime,
+                            Setting::BreakDuration>(changes))
+    {
+        return; // nothing related to the schedule
+    }
+
+    if (Settings::contains<Setting::BreakRules>(changes))
+    {
+        onBreakRulesChanged();
+    }
+    if (Settings::contains<Setting::BreakInterval>(changes))
+    {
+        onBreakIntervalChanged(settings().breakInterval());
+    }
+    if (Settings::contains<Setting::WorkTime>(changes))
+    {
+        onWorkTimeChanged(settings().workTime());
+    }
+    if (Settings::contains<Setting::BreakDuration>(changes) && m_activeRule == BreakSchedule::sc_noRule)
+    {
+        emit breakDurationChanged(breakDuration());
+    }
+
+    updateSchedule(); // once for all changes
 }
 
 void Controller::onBreakIntervalChanged(int breakInterval)
@@ -247,7 +524,8 @@ void Controller::onBreakIntervalChanged(int breakInterval)
     if (elapsedWorkPeriod > breakInterval) // break should be taken now
     {
         m_lastRequestTime = breakInterval;
-        emit breakStartRequest(); // inform about it
+        m_mainBreakRequested = true;
+        requestBreak(BreakSchedule::sc_noRule); // inform about it
     }
 }
 
@@ -259,3 +537,25 @@ void Controller::onWorkTimeChanged(int workTime)
         emit workEndRequest(); // inform about it
     }
 }
+
+void Controller::onBreakRulesChanged()
+{
+    m_breakSchedule.setRules(settings().breakRules(), timer().elapsedWorkTimeMsecs());
+
+    // indexes of previous rules are not valid anymore
+    if (m_pendingRule != BreakSchedule::sc_noRule)
+    {
+        m_pendingRule = BreakSchedule::sc_noRule;
+        m_breakRequested = m_mainBreakRequested;
+    }
+    setActiveRule(BreakSchedule::sc_noRule);
+}
+
+void Controller::onSleepDetected(int duration)
+{
+    // sleep during break is already counted to the break by timer
+    if (timer().activePeriodType() == TimerController::PeriodType::Work)
+    {
+        finishBreak(duration); // rules with breaks not longer than sleep are satisfied
+    }
+}
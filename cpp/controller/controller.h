@@ -31,6 +31,10 @@
 
 #include "workers/backupmanager.h"
 #include "workers/savemanager.h"
+#include "workers/scheduler.h"
+
+#include "model/breakschedule.h"
+#include "utility/thresholdmonitor.h"
 
 class Controller final : public QObject
 {
@@ -42,6 +46,7 @@ class Controller final : public QObject
     Q_PROPERTY(UpdateController* updater READ updaterPtr CONSTANT)
 
     Q_PROPERTY(State state READ state NOTIFY stateChanged)
+    Q_PROPERTY(int breakDuration READ breakDuration NOTIFY breakDurationChanged)
 
 public:
     enum class State : qint8
@@ -53,22 +58,48 @@ public:
     };
 
     Controller();
+    /*!
+     * \brief Creates controller counting time of the given clock.
+     * Used to run the logic on a virtual time.
+     */
+    explicit Controller(Clock &clock);
     SettingsController &settings();
     TimerController &timer();
     UpdateController &updater();
 
     State state() const;
     bool isWorking() const;
+    /*!
+     * \brief Returns duration of current break in seconds.
+     *
+     * It depends on break rule which break has been taken.
+     */
+    int breakDuration();
 
     void save();
     void clear();
 
+    /*!
+     * \brief Saves current state to the named slot.
+     */
+    bool saveSlot(const QString &name);
+    /*!
+     * \brief Restores state saved in the named slot.
+     * Controller is recovered as after a breakdown.
+     */
+    bool restoreSlot(const QString &name);
+    /*!
+     * \brief Restores state saved in the most recently saved slot.
+     */
+    bool restoreLatestSlot();
+
     Q_INVOKABLE QPoint cursorPos() const;
 
     Q_INVOKABLE void openHelp() const;
 
 signals:
     void stateChanged(State state) const;
+    void breakDurationChanged(int breakDuration) const;
 
     void breakStartRequest() const;
     void breakEndRequest() const;
@@ -93,47 +124,122 @@ private:
     // workers
     BackupManager m_backupManager;
     SaveManager m_saveManager;
+    Scheduler m_scheduler;
+    ThresholdMonitor<Scheduler::Event> m_thresholds;   //! detects reaching of events targets
+
+    BreakSchedule m_breakSchedule;  //! timeline of additional break rules
+
+    static const QList<Scheduler::Event> sc_events;
 
     // values
     State m_state = State::Off; //! current state
     int m_postponeDuration = 0;     //! sum duration for all postpones for current break
     int m_lastRequestTime = 0;     //! last time when postpone button was clicked
+    bool m_breakRequested = false;  //! true if break request waits for answer
+    bool m_mainBreakRequested = false;  //! true if main break is among requested
+    int m_pendingRule = BreakSchedule::sc_noRule;   //! longest requested break rule (main if none)
+    int m_activeRule = BreakSchedule::sc_noRule;    //! rule of current break (main if none)
+    bool m_recovering = false;  //! true while recovered times are applied
 
     SettingsController *settingsPtr();
     TimerController *timerPtr();
     UpdateController *updaterPtr();
 
+    /*!
+     * \brief Returns elapsed time at which event happens (in ms).
+     */
+    qint64 eventTarget(Scheduler::Event event);
+    /*!
+     * \brief Returns currently elapsed time related to event (in ms).
+     */
+    qint64 eventElapsed(Scheduler::Event event);
+    /*!
+     * \brief Returns period type during which event can happen.
+     */
+    static TimerController::PeriodType eventPeriodType(Scheduler::Event event);
+
+    /*!
+     * \brief Handles events which targets have been crossed
+     * since last check, even if elapsed times jumped over them.
+     */
+    void checkThresholds();
+    /*!
+     * \brief Accepts current elapsed times without handling crossings.
+     */
+    void resetThresholds();
+    void handleEvent(Scheduler::Event event);
+
+    /*!
+     * \brief Returns break duration of the rule (in secs).
+     * BreakSchedule::sc_noRule stands for the main break.
+     */
+    int ruleDuration(int rule);
+    /*!
+     * \brief Requests breaks of all additional rules which deadlines have passed.
+     */
+    void checkBreakRules();
+    /*!
+     * \brief Informs about break of the rule, longest requested break is offered.
+     */
+    void requestBreak(int rule);
+    void clearBreakRequest();
+    void setActiveRule(int rule);
+    /*!
+     * \brief Restarts counting of all rules satisfied by a break.
+     *
+     * \param duration  duration of the break (in secs)
+     */
+    void finishBreak(int duration);
+
 private slots:
     void setState(State state);
 
-    void onBackupData(const BackupManager::Data &data);
-
     /*!
-     * \brief Method handling change in elapsed time of break.
+     * \brief Recalculates deadlines of all events
+     * for current state of timer and settings.
+     */
+    void updateSchedule();
+    /*!
+     * \brief Method handling direct change of elapsed times.
+     */
+    void onTimeAdjusted();
+    /*!
+     * \brief Method handling deadline of scheduled event.
+     */
+    void onScheduledEvent();
+    /*!
+     * \brief Method handling system sleep detected by timer.
      *
-     * Check if end should be finished and informs about this.
+     * Sleep long enough during work is treated as a break.
      *
-     * \param elapsedBreakDuration  elapsed time of break.
+     * \param duration  sleep duration (in secs)
      */
-    void onElapsedBreakDurationChange(int elapsedBreakDuration);
+    void onSleepDetected(int duration);
+
+    void onBackupData(const BackupManager::Data &data);
+
     /*!
-     * \brief Method handling change in elapsed time of work period.
-     *
-     * Check if break is needed and informs about it.
-     * Takes into account also postponing of break.
+     * \brief Brings backup data and counting state up to date with timer.
      *
-     * \param elapsedWorkPeriod     elapsed time of work period.
+     * Elapsed times are read on demand, as timer publishes
+     * them rarely when nothing is observed.
      */
-    void onElapsedWorkPeriodChange(int elapsedWorkPeriod);
+    void updateBackupData();
     /*!
-     * \brief Method handling change in total work time elapsed.
+     * \brief Writes published times and counting state to the live state file.
+     * Counting state is written on each transition, so restored times are exact.
+     */
+    void updateLiveState();
+
+    /*!
+     * \brief Method handling change of settings.
      *
-     * Check if work should be finished and informs about it.
+     * Applies all changed settings, then recalculates
+     * schedule once.
      *
-     * \param elapsedWorkTime   total work time elapsed
+     * \param changes   changed settings
      */
-    void onElapsedWorkTimeChange(int elapsedWorkTime);
-
+    void onSettingsChanged(const Settings::Changes &changes);
     /*!
      * \brief Method handling change in break interval.
      *
@@ -148,6 +254,12 @@ private slots:
      * \param workTime  new work time setting
      */
     void onWorkTimeChanged(int workTime);
+    /*!
+     * \brief Method handling change in additional break rules.
+     *
+     * All rules start counting from current work time.
+     */
+    void onBreakRulesChanged();
 };
 
 #endif // CONTROLLER_H
@@ -23,43 +23,89 @@
 #include "settingscontroller.h"
 #include <QCoreApplication>
 
+const char *SettingsController::sc_backendVariable = "RESTO_SETTINGS_BACKEND";
 const QStringList SettingsController::sc_availableColors = { "#19886F", "#EC811B", "#682C90", "#C0159B", "#008000", "#0958EC", "#666666" };
 
+template <typename S, typename Arg, typename Value>
+void SettingsController::addNotifier(void (SettingsController::*signal)(Arg) const,
+                                     Value (SettingsController::*getter)() const)
+{
+    m_notifiers[Setting::IndexOf<S>::value] = [this, signal, getter]() {
+        emit (this->*signal)((this->*getter)());
+    };
+}
+
+template <typename S>
+void SettingsController::addNotifier(void (SettingsController::*signal)() const)
+{
+    m_notifiers[Setting::IndexOf<S>::value] = [this, signal]() {
+        emit (this->*signal)();
+    };
+}
+
+Settings::Backend SettingsController::backend()
+{
+    // binary backend is optional, e.g. for slow home directories
+    return (qgetenv(sc_backendVariable) == "binary") ? Settings::Backend::Binary
+                                                     : Settings::Backend::Ini;
+}
+
 SettingsController::SettingsController(QObject *parent)
-    : QObject(parent), m_settings(QCoreApplication::organizationName(), QCoreApplication::applicationName())
+    : QObject(parent), m_settings(QCoreApplication::organizationName(), QCoreApplication::applicationName(), backend()),
+      m_notifiers(Setting::sc_count)
 {
-    m_settings.setDefaultApplicationColor(sc_availableColors.first());
+    addNotifier<Setting::BreakDuration>(&SettingsController::breakDurationChanged, &SettingsController::breakDuration);
+    addNotifier<Setting::BreakInterval>(&SettingsController::breakIntervalChanged, &SettingsController::breakInterval);
+    addNotifier<Setting::WorkTime>(&SettingsController::workTimeChanged, &SettingsController::workTime);
+    addNotifier<Setting::PostponeTime>(&SettingsController::postponeTimeChanged, &SettingsController::postponeTime);
+    addNotifier<Setting::AutoStart>(&SettingsController::autoStartChanged, &SettingsController::autoStart);
+    addNotifier<Setting::BreakRules>(&SettingsController::breakRulesChanged);
+    addNotifier<Setting::WindowPosition>(&SettingsController::windowPositionChanged, &SettingsController::windowPosition);
+    addNotifier<Setting::WindowSize>(&SettingsController::windowSizeChanged, &SettingsController::windowSize);
+    addNotifier<Setting::ApplicationColor>(&SettingsController::applicationColorChanged, &SettingsController::applicationColor);
+    addNotifier<Setting::TrayAvailable>(&SettingsController::trayAvailableChanged, &SettingsController::trayAvailable);
+    addNotifier<Setting::ShowTrayInfo>(&SettingsController::showTrayInfoChanged, &SettingsController::showTrayInfo);
+    addNotifier<Setting::AutoHide>(&SettingsController::autoHideChanged, &SettingsController::autoHide);
+    addNotifier<Setting::HideOnClose>(&SettingsController::hideOnCloseChanged, &SettingsController::hideOnClose);
+    addNotifier<Setting::UpdateVersion>(&SettingsController::updateVersionChanged, &SettingsController::updateVersion);
+    addNotifier<Setting::NextUpdateCheck>(&SettingsController::nextUpdateCheckChanged, &SettingsController::nextUpdateCheck);
+
+    connect(&m_settings, &Settings::valuesChanged, this, &SettingsController::onValuesChanged);
 }
 
 int SettingsController::breakDuration() const
 {
-    return m_settings.breakDuration();
+    return m_settings.value<Setting::BreakDuration>();
 }
+
 int SettingsController::breakInterval() const
 {
-    return m_settings.breakInterval();
+    return m_settings.value<Setting::BreakInterval>();
 }
+
 int SettingsController::workTime() const
 {
-    return m_settings.workTime();
+    return m_settings.value<Setting::WorkTime>();
 }
+
 int SettingsController::postponeTime() const
 {
-    return m_settings.postponeTime();
+    return m_settings.value<Setting::PostponeTime>();
 }
+
 bool SettingsController::autoStart() const
 {
-    return m_settings.autoStart();
+    return m_settings.value<Setting::AutoStart>();
 }
 
-QPoint SettingsController::windowPosition() const
+QList<BreakRule> SettingsController::breakRules() const
 {
-    return m_settings.windowPosition();
+    return m_settings.value<Setting::BreakRules>();
 }
 
-QSize SettingsController::windowSize() const
+QPoint SettingsController::windowPosition() const
 {
-    return m_settings.windowSize();
+    return m_settings.value<Setting::WindowPosition>();
 }
 
 QStringList SettingsController::availableColors() const
@@ -67,159 +113,167 @@ QStringList SettingsController::availableColors() const
     return sc_availableColors;
 }
 
+QSize SettingsController::windowSize() const
+{
+    return m_settings.value<Setting::WindowSize>();
+}
+
 QColor SettingsController::applicationColor() const
 {
-    return m_settings.applicationColor();
+    const auto &color = m_settings.value<Setting::ApplicationColor>();
+    return color.isValid() ? color : QColor(sc_availableColors.first());
 }
 
 bool SettingsController::trayAvailable() const
 {
-    return m_settings.trayAvailable();
+    return m_settings.value<Setting::TrayAvailable>();
 }
 
 bool SettingsController::showTrayInfo() const
 {
-    return m_settings.showTrayInfo();
+    return m_settings.value<Setting::ShowTrayInfo>();
 }
 
 bool SettingsController::autoHide() const
 {
-    return m_settings.autoHide();
+    return m_settings.value<Setting::AutoHide>();
 }
 
 bool SettingsController::hideOnClose() const
 {
-    return m_settings.hideOnClose();
+    return m_settings.value<Setting::HideOnClose>();
 }
 
 QString SettingsController::updateVersion() const
 {
-    return m_settings.updateVersion();
+    return m_settings.value<Setting::UpdateVersion>();
 }
 
 QDateTime SettingsController::nextUpdateCheck() const
 {
-    return m_settings.nextUpdateCheck();
+    return m_settings.value<Setting::NextUpdateCheck>();
 }
 
-void SettingsController::setBreakDuration(int breakDuration)
+QDateTime SettingsController::lastUpdateCheck() const
 {
-    if (m_settings.breakDuration() == breakDuration)
-        return;
+    return m_settings.value<Setting::LastUpdateCheck>();
+}
 
-    m_settings.setBreakDuration(breakDuration);
-    emit breakDurationChanged(breakDuration);
+int SettingsController::updateSeed() const
+{
+    return m_settings.value<Setting::UpdateSeed>();
 }
-void SettingsController::setBreakInterval(int breakInterval)
+
+void SettingsController::setBreakDuration(int breakDuration)
 {
-    if (m_settings.breakInterval() == breakInterval)
-        return;
+    m_settings.setValue<Setting::BreakDuration>(breakDuration);
+}
 
-    m_settings.setBreakInterval(breakInterval);
-    emit breakIntervalChanged(breakInterval);
+void SettingsController::setBreakInterval(int breakInterval)
+{
+    m_settings.setValue<Setting::BreakInterval>(breakInterval);
 }
+
 void SettingsController::setWorkTime(int workTime)
 {
-    if (m_settings.workTime() == workTime)
-        return;
-
-    m_settings.setWorkTime(workTime);
-    emit workTimeChanged(workTime);
+    m_settings.setValue<Setting::WorkTime>(workTime);
 }
+
 void SettingsController::setPostponeTime(int postponeTime)
 {
-    if (m_settings.postponeTime() == postponeTime)
-        return;
-
-    m_settings.setPostponeTime(postponeTime);
-    emit postponeTimeChanged(postponeTime);
+    m_settings.setValue<Setting::PostponeTime>(postponeTime);
 }
+
 void SettingsController::setAutoStart(bool autoStart)
 {
-    if (m_settings.autoStart() == autoStart)
-        return;
+    m_settings.setValue<Setting::AutoStart>(autoStart);
+}
 
-    m_settings.setAutoStart(autoStart);
-    emit autoStartChanged(autoStart);
+void SettingsController::setBreakRules(const QList<BreakRule> &breakRules)
+{
+    m_settings.setValue<Setting::BreakRules>(breakRules);
 }
 
 void SettingsController::setWindowPosition(const QPoint &windowPosition)
 {
-    if (m_settings.windowPosition() == windowPosition)
-        return;
-
-    m_settings.setWindowPosition(windowPosition);
-    emit windowPositionChanged(windowPosition);
+    m_settings.setValue<Setting::WindowPosition>(windowPosition);
 }
 
 void SettingsController::setWindowSize(const QSize &windowSize)
 {
-    if (m_settings.windowSize() == windowSize)
-        return;
-
-    m_settings.setWindowSize(windowSize);
-    emit windowSizeChanged(windowSize);
+    m_settings.setValue<Setting::WindowSize>(windowSize);
 }
 
-void SettingsController::setApplicationColor(QColor color)
+void SettingsController::setApplicationColor(QColor applicationColor)
 {
-    if (m_settings.applicationColor() == color)
-        return;
-
-    m_settings.setApplicationColor(color);
-    emit applicationColorChanged(color);
+    m_settings.setValue<Setting::ApplicationColor>(applicationColor);
 }
 
 void SettingsController::setTrayAvailable(bool trayAvailable)
 {
-    if (m_settings.trayAvailable() == trayAvailable)
-        return;
-
-    m_settings.setTrayAvailable(trayAvailable);
-    emit trayAvailableChanged(trayAvailable);
+    m_settings.setValue<Setting::TrayAvailable>(trayAvailable);
 }
 
 void SettingsController::setShowTrayInfo(bool showTrayInfo)
 {
-    if (m_settings.showTrayInfo() == showTrayInfo)
-        return;
-
-    m_settings.setShowTrayInfo(showTrayInfo);
-    emit showTrayInfoChanged(showTrayInfo);
+    m_settings.setValue<Setting::ShowTrayInfo>(showTrayInfo);
 }
 
 void SettingsController::setAutoHide(bool autoHide)
 {
-    if (m_settings.autoHide() == autoHide)
-        return;
-
-    m_settings.setAutoHide(autoHide);
-    emit autoHideChanged(autoHide);
+    m_settings.setValue<Setting::AutoHide>(autoHide);
 }
 
 void SettingsController::setHideOnClose(bool hideOnClose)
 {
-    if (m_settings.hideOnClose() == hideOnClose)
-        return;
-
-    m_settings.setHideOnClose(hideOnClose);
-    emit hideOnCloseChanged(hideOnClose);
+    m_settings.setValue<Setting::HideOnClose>(hideOnClose);
 }
 
 void SettingsController::setUpdateVersion(const QString &updateVersion)
 {
-    if (m_settings.updateVersion() == updateVersion)
-        return;
-
-    m_settings.setUpdateVersion(updateVersion);
-    emit updateVersionChanged(updateVersion);
+    m_settings.setValue<Setting::UpdateVersion>(updateVersion);
 }
 
 void SettingsController::setNextUpdateCheck(const QDateTime &nextUpdateCheck)
 {
-    if (m_settings.nextUpdateCheck() == nextUpdateCheck)
-        return;
+    m_settings.setValue<Setting::NextUpdateCheck>(nextUpdateCheck);
+}
+
+void SettingsController::setLastUpdateCheck(const QDateTime &lastUpdateCheck)
+{
+    m_settings.setValue<Setting::LastUpdateCheck>(lastUpdateCheck);
+}
+
+void SettingsController::setUpdateSeed(int updateSeed)
+{
+    m_settings.setValue<Setting::UpdateSeed>(updateSeed);
+}
+
+void SettingsController::resetValues()
+{
+    m_settings.resetValues();
+}
+
+void SettingsController::beginTransaction()
+{
+    m_settings.beginTransaction();
+}
+
+void SettingsController::commitTransaction()
+{
+    m_settings.commitTransaction();
+}
 
-    m_settings.setNextUpdateCheck(nextUpdateCheck);
-    emit nextUpdateCheckChanged(nextUpdateCheck);
+void SettingsController::rollbackTransaction()
+{
+    m_settings.rollbackTransaction();
+}
+
+void SettingsController::onValuesChanged(const Settings::Changes &changes)
+{
+    for (int index = 0; index < Setting::sc_count; ++index) {
+        if (changes.test(index) && m_notifiers.at(index)) // internal settings have no notifier
+            m_notifiers.at(index)();
+    }
+    emit changed(changes);
 }
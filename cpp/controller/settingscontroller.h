@@ -25,11 +25,20 @@
 
 #include <QObject>
 #include <QDateTime>
+#include <QVector>
+
+#include <functional>
 
 #include "model/settings.h"
 
 /*!
  * \brief Controller class to handle settings.
+ *
+ * Exposes settings as properties. Change notifications
+ * of all properties come from Settings::valuesChanged().
+ *
+ * Changes made between beginTransaction() and commitTransaction()
+ * are written at once and reported with a single changed().
  */
 class SettingsController final : public QObject
 {
@@ -63,6 +72,7 @@ public:
     int workTime() const;
     int postponeTime() const;
     bool autoStart() const;
+    QList<BreakRule> breakRules() const;
 
     QPoint windowPosition() const;
     QSize windowSize() const;
@@ -77,13 +87,31 @@ public:
 
     QString updateVersion() const;
     QDateTime nextUpdateCheck() const;
+    QDateTime lastUpdateCheck() const;
+    int updateSeed() const;
+
+    /*!
+     * \brief Sets default values of all settings.
+     */
+    void resetValues();
+
+    Q_INVOKABLE void beginTransaction();
+    Q_INVOKABLE void commitTransaction();
+    Q_INVOKABLE void rollbackTransaction();
 
 signals:
+    /*!
+     * \brief Informs about all settings changed at once,
+     * after change signals of particular properties.
+     */
+    void changed(const Settings::Changes &changes) const;
+
     void breakDurationChanged(int breakDuration) const;
     void breakIntervalChanged(int breakInterval) const;
     void workTimeChanged(int workTime) const;
     void postponeTimeChanged(int postponeTime) const;
     void autoStartChanged(bool autoStart) const;
+    void breakRulesChanged() const;
 
     void windowPositionChanged(const QPoint &windowPosition) const;
     void windowSizeChanged(const QSize &windowSize) const;
@@ -103,6 +131,7 @@ public slots:
     void setWorkTime(int workTime);
     void setPostponeTime(int postponeTime);
     void setAutoStart(bool autoStart);
+    void setBreakRules(const QList<BreakRule> &breakRules);
 
     void setWindowPosition(const QPoint &windowPosition);
     void setWindowSize(const QSize &windowSize);
@@ -115,6 +144,8 @@ public slots:
 
     void setUpdateVersion(const QString &updateVersion);
     void setNextUpdateCheck(const QDateTime &nextUpdateCheck);
+    void setLastUpdateCheck(const QDateTime &lastUpdateCheck);
+    void setUpdateSeed(int updateSeed);
 
 private:
     /*!
@@ -122,7 +153,27 @@ private:
      */
     Settings m_settings;
 
+    QVector<std::function<void()>> m_notifiers;    //! emit change signal of setting (by index)
+
+    /*!
+     * \brief Binds change signal of property to setting S.
+     */
+    template <typename S, typename Arg, typename Value>
+    void addNotifier(void (SettingsController::*signal)(Arg) const,
+                     Value (SettingsController::*getter)() const);
+    template <typename S>
+    void addNotifier(void (SettingsController::*signal)() const);
+
     static const QStringList sc_availableColors;
+    static const char *sc_backendVariable;  //! environment variable selecting settings backend
+
+    /*!
+     * \brief Returns settings backend selected by the environment.
+     */
+    static Settings::Backend backend();
+
+private slots:
+    void onValuesChanged(const Settings::Changes &changes);
 };
 
 #endif // SETTINGSCONTROLLER_H
@@ -23,27 +23,54 @@
 #include "timercontroller.h"
 
 TimerController::TimerController(QObject *parent)
-    : QObject(parent)
+    : TimerController(Clock::system(), parent)
+{}
+TimerController::TimerController(Clock &clock, QObject *parent)
+    : QObject(parent), m_clock(clock), m_timer(clock)
 {
     m_timer.setTimerType(Qt::PreciseTimer);
-    m_timer.setInterval(1000);  // one second interval
+    m_timer.setInterval(sc_idleRefreshInterval);
 
-    connect(&m_timer, &QTimer::timeout, this, &TimerController::onTimeTic);
+    connect(&m_timer, &ClockTimer::timeout, this, &TimerController::onTimeTic);
 }
 
 int TimerController::elapsedBreakDuration() const
 {
-    return m_elapsedBreakDuration;
+    return static_cast<int>(elapsedBreakDurationMsecs() / 1000);
 }
 
 int TimerController::elapsedWorkPeriod() const
 {
-    return m_elapsedWorkPeriod;
+    return static_cast<int>(elapsedWorkPeriodMsecs() / 1000);
 }
 
 int TimerController::elapsedWorkTime() const
 {
-    return m_elapsedWorkTime;
+    return static_cast<int>(elapsedWorkTimeMsecs() / 1000);
+}
+
+qint64 TimerController::elapsedBreakDurationMsecs() const
+{
+    auto elapsed = m_breakDurationBase;
+    if (m_periodType == PeriodType::Break)
+        elapsed += segmentElapsed();
+    return elapsed;
+}
+
+qint64 TimerController::elapsedWorkPeriodMsecs() const
+{
+    auto elapsed = m_workPeriodBase;
+    if (m_periodType == PeriodType::Work)
+        elapsed += segmentElapsed();
+    return elapsed;
+}
+
+qint64 TimerController::elapsedWorkTimeMsecs() const
+{
+    auto elapsed = m_workTimeBase;
+    if (m_periodType == PeriodType::Work)
+        elapsed += segmentElapsed();
+    return elapsed;
 }
 
 TimerController::PeriodType TimerController::activePeriodType() const
@@ -51,6 +78,70 @@ TimerController::PeriodType TimerController::activePeriodType() const
     return m_periodType;
 }
 
+TimerController::Snapshot TimerController::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.elapsedBreakDuration = elapsedBreakDuration();
+    snapshot.elapsedWorkPeriod = elapsedWorkPeriod();
+    snapshot.elapsedWorkTime = elapsedWorkTime();
+    snapshot.periodType = m_periodType;
+    return snapshot;
+}
+
+TimerController::Segment TimerController::segment() const
+{
+    Segment segment;
+    segment.breakDurationBase = m_breakDurationBase;
+    segment.workPeriodBase = m_workPeriodBase;
+    segment.workTimeBase = m_workTimeBase;
+    if (m_running)
+    {
+        segment.startWallTime = m_clock.wallTime() - segmentElapsed();
+    }
+    segment.periodType = m_periodType;
+    return segment;
+}
+
+bool TimerController::isRunning() const
+{
+    return m_running;
+}
+
+bool TimerController::isObserved() const
+{
+    return !m_observers.isEmpty();
+}
+
+void TimerController::setObserved(QObject *observer, bool observed)
+{
+    if (!observer || m_observers.contains(observer) == observed)
+    {
+        return;
+    }
+
+    const bool wasObserved = isObserved();
+    if (observed)
+    {
+        m_observers.insert(observer);
+        connect(observer, &QObject::destroyed, this, &TimerController::onObserverDestroyed);
+    }
+    else
+    {
+        m_observers.remove(observer);
+        disconnect(observer, &QObject::destroyed, this, &TimerController::onObserverDestroyed);
+    }
+
+    if (wasObserved == isObserved())
+    {
+        return;
+    }
+
+    checkGap(); // against the previous interval, the timer restarts with the new one
+    publish(); // values could be outdated when nothing was observed
+    m_timer.setInterval(isObserved() ? sc_refreshInterval : sc_idleRefreshInterval);
+    emit observedChanged(isObserved());
+}
+
 void TimerController::start(bool restart)
 {
     if (restart)
@@ -61,11 +152,24 @@ void TimerController::start(bool restart)
         setElapsedWorkTime(0);
     }
 
+    if (!m_running)
+    {
+        m_running = true;
+        m_segmentStart = m_clock.monotonicTime();
+        resetGapCheck();
+    }
     m_timer.start();
+
+    emit timeAdjusted();
 }
 void TimerController::stop()
 {
+    commitSegment();
+    m_running = false;
     m_timer.stop();
+
+    publish();
+    emit timeAdjusted();
 }
 
 void TimerController::countBreakTime()
@@ -75,8 +179,11 @@ void TimerController::countBreakTime()
         return;
     }
 
+    commitSegment();
     m_periodType = PeriodType::Break;
     emit activePeriodTypeChanged(m_periodType);
+    publish();
+    emit timeAdjusted();
 }
 void TimerController::countWorkTime()
 {
@@ -85,82 +192,171 @@ void TimerController::countWorkTime()
         return;
     }
 
+    commitSegment();
     m_periodType = PeriodType::Work;
     emit activePeriodTypeChanged(m_periodType);
+    publish();
+    emit timeAdjusted();
 }
 
 void TimerController::setElapsedBreakDuration(int elapsedBreakDuration)
 {
-    if (m_elapsedBreakDuration == elapsedBreakDuration)
+    commitSegment();
+    m_breakDurationBase = elapsedBreakDuration * 1000LL;
+    publish();
+    emit timeAdjusted();
+}
+void TimerController::setElapsedWorkPeriod(int elapsedWorkPeriod)
+{
+    commitSegment();
+    m_workPeriodBase = elapsedWorkPeriod * 1000LL;
+    publish();
+    emit timeAdjusted();
+}
+void TimerController::setElapsedWorkTime(int elapsedWorkTime)
+{
+    commitSegment();
+    m_workTimeBase = elapsedWorkTime * 1000LL;
+    publish();
+    emit timeAdjusted();
+}
+
+qint64 TimerController::segmentElapsed() const
+{
+    return m_running ? m_clock.monotonicTime() - m_segmentStart : 0;
+}
+
+void TimerController::commitSegment()
+{
+    if (!m_running)
     {
         return;
     }
 
-    m_elapsedBreakDuration = elapsedBreakDuration;
-    emit elapsedBreakDurationChanged(elapsedBreakDuration);
+    const auto now = m_clock.monotonicTime();
+    const auto elapsed = now - m_segmentStart;
+    m_segmentStart = now;
+    switch (m_periodType)
+    {
+    case PeriodType::Break:
+        m_breakDurationBase += elapsed;
+        break;
+    case PeriodType::Work:
+        m_workPeriodBase += elapsed;
+        m_workTimeBase += elapsed;
+        break;
+    default:
+        Q_ASSERT(false);
+    }
 }
-void TimerController::setElapsedWorkPeriod(int elapsedWorkPeriod)
+
+void TimerController::resetGapCheck()
 {
-    if (m_elapsedWorkPeriod == elapsedWorkPeriod)
+    m_lastCheckTime = m_clock.monotonicTime();
+    m_lastCheckWallTime = m_clock.wallTime();
+}
+
+void TimerController::checkGap()
+{
+    if (!m_running)
     {
         return;
     }
 
-    m_elapsedWorkPeriod = elapsedWorkPeriod;
-    emit elapsedWorkPeriodChanged(elapsedWorkPeriod);
+    const auto time = m_clock.monotonicTime();
+    const auto monotonicDelta = time - m_lastCheckTime;
+    m_lastCheckTime = time;
+
+    const auto wallTime = m_clock.wallTime();
+    const auto wallDelta = wallTime - m_lastCheckWallTime;
+    m_lastCheckWallTime = wallTime;
+
+    const auto sleepDuration = wallDelta - monotonicDelta;
+    if (sleepDuration > sc_gapThreshold)
+    {
+        // system was suspended, monotonic clock has not counted this time
+        if (m_periodType == PeriodType::Break)
+        {
+            commitSegment();
+            m_breakDurationBase += sleepDuration;
+        }
+        emit sleepDetected(static_cast<int>(sleepDuration / 1000));
+        emit timeAdjusted();
+    }
+    else if (m_timer.isActive() && monotonicDelta > m_timer.interval() + sc_gapThreshold)
+    {
+        // process has not been running for a while, elapsed times
+        // already contain the stall, only deadlines need to catch up
+        emit timeAdjusted();
+    }
 }
-void TimerController::setElapsedWorkTime(int elapsedWorkTime)
+
+void TimerController::publish()
 {
-    if (m_elapsedWorkTime == elapsedWorkTime)
+    const auto current = snapshot();
+    if (current == m_published)
     {
         return;
     }
 
-    m_elapsedWorkTime = elapsedWorkTime;
-    emit elapsedWorkTimeChanged(elapsedWorkTime);
+    const auto previous = m_published;
+    m_published = current;
+
+    if (previous.elapsedBreakDuration != current.elapsedBreakDuration)
+        emit elapsedBreakDurationChanged(current.elapsedBreakDuration);
+    if (previous.elapsedWorkPeriod != current.elapsedWorkPeriod)
+        emit elapsedWorkPeriodChanged(current.elapsedWorkPeriod);
+    if (previous.elapsedWorkTime != current.elapsedWorkTime)
+        emit elapsedWorkTimeChanged(current.elapsedWorkTime);
+
+    emit snapshotChanged(current);
 }
 
-void TimerController::incrementWorkTime()
+void TimerController::onTimeTic()
 {
-    setElapsedWorkPeriod(elapsedWorkPeriod() + 1);
-    setElapsedWorkTime(elapsedWorkTime() + 1);
+    synchronize();
 }
-void TimerController::incrementBreakTime()
+
+void TimerController::onObserverDestroyed(QObject *observer)
 {
-    setElapsedBreakDuration(elapsedBreakDuration() + 1);
+    setObserved(observer, false);
 }
 
-void TimerController::onTimeTic()
+void TimerController::synchronize()
 {
-    switch (m_periodType)
-    {
-    case PeriodType::Break:
-        incrementBreakTime();
-        break;
-    case PeriodType::Work:
-        incrementWorkTime();
-        break;
-    default:
-        Q_ASSERT(false);
-    }
+    checkGap();
+    publish();
 }
 
 void TimerController::addTime(int time)
 {
-    const int newTime = time * 60;
-    setElapsedWorkPeriod(newTime + elapsedWorkPeriod());
-    setElapsedWorkTime(newTime + elapsedWorkTime());
+    const qint64 newTime = time * 60 * 1000LL;
+    commitSegment();
+    m_workPeriodBase += newTime;
+    m_workTimeBase += newTime;
+    publish();
+    emit timeAdjusted();
 }
 
 void TimerController::substractTime(int time)
 {
-    const int newTime = time * 60;
-    int newElapsedWork = elapsedWorkTime() - newTime;
-    if (newElapsedWork < 0)
-        newElapsedWork = 0;
-    int newElapsedPeriod = elapsedWorkPeriod() - newTime;
-    if (newElapsedPeriod < 0)
-        newElapsedPeriod = 0;
-    setElapsedWorkPeriod(newElapsedPeriod);
-    setElapsedWorkTime(newElapsedWork);
+    const qint64 newTime = time * 60 * 1000LL;
+    commitSegment();
+    m_workPeriodBase = qMax(m_workPeriodBase - newTime, 0LL);
+    m_workTimeBase = qMax(m_workTimeBase - newTime, 0LL);
+    publish();
+    emit timeAdjusted();
+}
+
+bool TimerController::Snapshot::operator==(const TimerController::Snapshot &other) const
+{
+    return (elapsedBreakDuration == other.elapsedBreakDuration &&
+            elapsedWorkPeriod == other.elapsedWorkPeriod &&
+            elapsedWorkTime == other.elapsedWorkTime &&
+            periodType == other.periodType);
+}
+
+bool TimerController::Snapshot::operator!=(const TimerController::Snapshot &other) const
+{
+    return !(*this == other);
 }
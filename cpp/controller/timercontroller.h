@@ -24,8 +24,27 @@
 #define TIMERCONTROLLER_H
 
 #include <QObject>
-#include <QTimer>
-
+#include <QSet>
+
+#include "utility/clock.h"
+
+/*!
+ * \brief Controller class counting work and break time.
+ *
+ * Elapsed times are measured with a monotonic clock,
+ * so they stay exact regardless of how often (or how late)
+ * the refresh tick is delivered. The tick is used only
+ * to publish current values to the observers.
+ *
+ * When nothing on screen shows the times (no observer
+ * is registered), the tick is slowed down to an idle rate.
+ *
+ * On each refresh gaps in time are detected by comparing
+ * monotonic and wall clocks. A gap is either a system sleep
+ * (wall clock passed, monotonic did not) or a stall (refresh
+ * came much later than expected). Elapsed times are caught
+ * up in one step in both cases.
+ */
 class TimerController final : public QObject
 {
     Q_OBJECT
@@ -34,6 +53,7 @@ class TimerController final : public QObject
     Q_PROPERTY(int elapsedWorkPeriod READ elapsedWorkPeriod NOTIFY elapsedWorkPeriodChanged)
     Q_PROPERTY(int elapsedWorkTime READ elapsedWorkTime NOTIFY elapsedWorkTimeChanged)
     Q_PROPERTY(PeriodType activePeriodType READ activePeriodType NOTIFY activePeriodTypeChanged)
+    Q_PROPERTY(bool observed READ isObserved NOTIFY observedChanged)
 
 public:
     enum class PeriodType : qint8
@@ -42,14 +62,70 @@ public:
         Work
     };
 
+    /*!
+     * \brief Structure with all published values of one refresh.
+     */
+    struct Snapshot {
+        int elapsedBreakDuration = 0;
+        int elapsedWorkPeriod = 0;
+        int elapsedWorkTime = 0;
+        PeriodType periodType = PeriodType::Work;
+
+        bool operator==(const Snapshot &other) const;
+        bool operator!=(const Snapshot &other) const;
+    };
+
+    /*!
+     * \brief Structure with counting state, from which
+     * elapsed times can be computed at any later time.
+     */
+    struct Segment {
+        // times counted before current segment (in ms)
+        qint64 breakDurationBase = 0;
+        qint64 workPeriodBase = 0;
+        qint64 workTimeBase = 0;
+        qint64 startWallTime = -1;  //! current segment start (ms since epoch), -1 if not counting
+        PeriodType periodType = PeriodType::Work;
+    };
+
     explicit TimerController(QObject *parent = 0);
+    explicit TimerController(Clock &clock, QObject *parent = 0);
 
     int elapsedBreakDuration() const;
     int elapsedWorkPeriod() const;
     int elapsedWorkTime() const;
 
+    // elapsed times with full precision (in ms)
+    qint64 elapsedBreakDurationMsecs() const;
+    qint64 elapsedWorkPeriodMsecs() const;
+    qint64 elapsedWorkTimeMsecs() const;
+
     PeriodType activePeriodType() const;
 
+    /*!
+     * \brief Returns current values of all counters.
+     */
+    Snapshot snapshot() const;
+    /*!
+     * \brief Returns current counting state.
+     * It changes only on start, stop, period change and time adjustments.
+     */
+    Segment segment() const;
+
+    bool isRunning() const;
+
+    bool isObserved() const;
+    /*!
+     * \brief Registers or unregisters an object which currently
+     * presents elapsed times to the user.
+     *
+     * Objects are unregistered automatically on destruction.
+     *
+     * \param observer  object presenting elapsed times
+     * \param observed  true if times are visible to the user
+     */
+    Q_INVOKABLE void setObserved(QObject *observer, bool observed);
+
 signals:
     void elapsedBreakDurationChanged(int elapsedBreakDuration) const;
     void elapsedWorkPeriodChanged(int elapsedWorkPeriod) const;
@@ -57,6 +133,31 @@ signals:
 
     void activePeriodTypeChanged(PeriodType activePeriodType) const;
 
+    /*!
+     * \brief Emitted once per refresh if any published value changed.
+     * Preferred over separate change signals by consumers
+     * which need more than one value.
+     */
+    void snapshotChanged(const TimerController::Snapshot &snapshot) const;
+
+    /*!
+     * \brief Emitted when counting is started or stopped,
+     * active period changes or elapsed times are set directly.
+     * Not emitted when time simply passes.
+     */
+    void timeAdjusted() const;
+
+    void observedChanged(bool observed) const;
+
+    /*!
+     * \brief Emitted when a system sleep has been detected
+     * while counting. Sleep is added to elapsed break duration
+     * if break was counted, it is never counted as work.
+     *
+     * \param duration  sleep duration (in secs)
+     */
+    void sleepDetected(int duration) const;
+
 public slots:
     void start(bool restart);
     void stop();
@@ -71,20 +172,64 @@ public slots:
     void addTime(int time);
     void substractTime(int time);
 
+    /*!
+     * \brief Checks for time gaps and publishes current values.
+     */
+    void synchronize();
+
 private:
-    QTimer m_timer;
+    static const int sc_refreshInterval = 1000; // ms
+    static const int sc_idleRefreshInterval = 60*1000;  // ms, used when nothing is observed
+    static const int sc_gapThreshold = 30*1000; // ms, minimal difference treated as a gap
+
+    Clock &m_clock;
+    ClockTimer m_timer;         //! used only to refresh published values
+    qint64 m_segmentStart = 0;  //! monotonic time of currently counted segment start
+    bool m_running = false;
+
+    qint64 m_lastCheckTime = 0;     //! monotonic time of last gap check
+    qint64 m_lastCheckWallTime = 0; //! wall time of last gap check (ms since epoch)
+
+    QSet<QObject*> m_observers; //! objects presenting elapsed times
 
     PeriodType m_periodType = PeriodType::Work;
 
-    int m_elapsedBreakDuration = 0;
-    int m_elapsedWorkPeriod = 0;
-    int m_elapsedWorkTime = 0;
+    // times counted before current segment (in ms)
+    qint64 m_breakDurationBase = 0;
+    qint64 m_workPeriodBase = 0;
+    qint64 m_workTimeBase = 0;
+
+    Snapshot m_published;   //! lastly published values
+
+    /*!
+     * \brief Returns time elapsed in current segment (in ms).
+     * Zero if timer is not running.
+     */
+    qint64 segmentElapsed() const;
+    /*!
+     * \brief Moves time elapsed in current segment
+     * to the active period counters and starts a new segment.
+     */
+    void commitSegment();
+    /*!
+     * \brief Sets reference points for gap detection.
+     */
+    void resetGapCheck();
+    /*!
+     * \brief Detects sleep or stall since last check.
+     */
+    void checkGap();
+    /*!
+     * \brief Emits change signals for values
+     * which differ from lastly published ones.
+     */
+    void publish();
 
 private slots:
-    void incrementWorkTime();
-    void incrementBreakTime();
-
     void onTimeTic();
+    void onObserverDestroyed(QObject *observer);
 };
 
+Q_DECLARE_METATYPE(TimerController::Snapshot)
+
 #endif // TIMERCONTROLLER_H
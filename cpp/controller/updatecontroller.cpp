@@ -27,21 +27,47 @@
 #include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QApplication>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QRegularExpression>
 //#include <QVersionNumber> // temporary do not use this to keep support for Qt 5.5.1
-#include <QTimer>
 #include <QDesktopServices>
 
 #include "controller/settingscontroller.h"
 
+const QLatin1String UpdateController::sc_cacheFileName = QLatin1String("version.json");
+
 UpdateController::UpdateController(SettingsController &settingsController, const QUrl &versionUrl, QObject *parent)
-    : QObject(parent), m_settingsController(settingsController), m_versionUrl(versionUrl)
+    : UpdateController(settingsController, versionUrl, Clock::system(), parent)
+{}
+UpdateController::UpdateController(SettingsController &settingsController, const QUrl &versionUrl, Clock &clock, QObject *parent)
+    : QObject(parent), m_settingsController(settingsController), m_clock(clock),
+      m_sourceVersionUrl(versionUrl), m_versionUrl(versionUrl), m_retryTimer(clock),
+      m_scheduleTimer(clock), m_downloader(clock)
 {
     checkPlatformInfo();
+    initializeSeed();
+    loadCache();
+
+    m_retryTimer.setSingleShot(true);
+    m_scheduleTimer.setSingleShot(true);
 
     // connections
-    connect(&m_nam, &QNetworkAccessManager::finished,
-            this, &UpdateController::onNetworReply);
+    connect(&m_retryTimer, &ClockTimer::timeout,
+            this, &UpdateController::getVersionResponse);
+    connect(&m_scheduleTimer, &ClockTimer::timeout,
+            this, &UpdateController::onScheduledCheck);
+
+    m_downloader.setRateLimit(sc_downloadRateLimit);
+    connect(&m_downloader, &UpdateDownloader::progress,
+            this, &UpdateController::downloadProgress);
+    connect(&m_downloader, &UpdateDownloader::finished,
+            this, &UpdateController::onDownloadFinished);
+    connect(&m_downloader, &UpdateDownloader::error,
+            this, &UpdateController::onDownloadError);
 }
 
 bool UpdateController::updateAvailable() const
@@ -51,24 +77,65 @@ bool UpdateController::updateAvailable() const
 
 void UpdateController::checkUpdateAvailable()
 {
-    if (m_curReply && !m_curReply->isFinished()) {
+    m_scheduledCheck = false;   // requested, so reported as such
+    startCheck();
+}
+
+void UpdateController::startCheck()
+{
+    if (m_curReply) {
         // if reply is processing, we just need to reset retry counter
         m_retryCounter = 0;
         return;
     }
+    m_retryTimer.stop();
 
+    if (!m_cache.manifest.isEmpty() && m_cache.expires.isValid()
+            && m_clock.currentDateTime() < m_cache.expires) {
+        // cached manifest is still fresh, no need to ask
+        parseVersionResponse(m_cache.manifest);
+        finishCheck(true);
+        return;
+    }
+
+    // temporary redirects are followed again on each check
+    m_versionUrl = m_cache.url.isValid() ? m_cache.url : m_sourceVersionUrl;
     getVersionResponse();
 }
 
+void UpdateController::scheduleUpdateCheck()
+{
+    const auto now = m_clock.currentDateTime();
+    qint64 delay = sc_startupDelay + m_seed % sc_startupSpread;
+
+    const auto lastCheck = m_settingsController.lastUpdateCheck();
+    if (lastCheck.isValid() && lastCheck <= now) {
+        delay = qMax(delay, now.msecsTo(lastCheck.addDays(sc_checkInterval)));
+    }
+
+    m_scheduleTimer.setInterval(static_cast<int>(delay));
+    m_scheduleTimer.start();
+}
+
 void UpdateController::download()
 {
-    QDesktopServices::openUrl(m_platformDownloadUrl);
+    if (m_platformHash.isEmpty()) { // cannot be verified
+        QDesktopServices::openUrl(m_platformDownloadUrl);
+        return;
+    }
+    emit downloadStarted();
+    m_downloader.start(m_platformDownloadUrl, m_platformHash);
+}
+
+void UpdateController::cancelDownload()
+{
+    m_downloader.cancel();
 }
 
 void UpdateController::postpone()
 {
     m_settingsController.setUpdateVersion(m_newestVersion);
-    m_settingsController.setNextUpdateCheck(QDateTime::currentDateTime().addDays(sc_postponeInterval));
+    m_settingsController.setNextUpdateCheck(m_clock.currentDateTime().addDays(sc_postponeInterval));
 }
 
 void UpdateController::skip()
@@ -129,9 +196,140 @@ void UpdateController::checkPlatformInfo()
     }
 }
 
+QString UpdateController::cachePath() const
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).absoluteFilePath(sc_cacheFileName);
+}
+
+void UpdateController::loadCache()
+{
+    QFile file(cachePath());
+    if (!file.open(QFile::ReadOnly))
+        return;
+
+    auto cacheObj = QJsonDocument::fromJson(file.readAll()).object();
+    m_cache.sourceUrl = QUrl(cacheObj.value("sourceUrl").toString());
+    if (m_cache.sourceUrl != m_sourceVersionUrl) {
+        m_cache = VersionCache(); // cached for a different version url
+        return;
+    }
+
+    m_cache.url = QUrl(cacheObj.value("url").toString());
+    m_cache.eTag = cacheObj.value("eTag").toString().toLatin1();
+    m_cache.lastModified = cacheObj.value("lastModified").toString().toLatin1();
+    m_cache.expires = QDateTime::fromString(cacheObj.value("expires").toString(), Qt::ISODate);
+    m_cache.manifest = cacheObj.value("manifest").toObject();
+
+    if (m_cache.url.isValid())
+        m_versionUrl = m_cache.url;
+}
+
+void UpdateController::saveCache() const
+{
+    QJsonObject cacheObj;
+    cacheObj.insert("sourceUrl", m_sourceVersionUrl.toString());
+    cacheObj.insert("url", m_cache.url.toString());
+    cacheObj.insert("eTag", QString::fromLatin1(m_cache.eTag));
+    cacheObj.insert("lastModified", QString::fromLatin1(m_cache.lastModified));
+    cacheObj.insert("expires", m_cache.expires.toString(Qt::ISODate));
+    cacheObj.insert("manifest", m_cache.manifest);
+
+    auto cacheDir = QFileInfo(cachePath()).absoluteDir();
+    if (!cacheDir.exists())
+        cacheDir.mkpath(cacheDir.absolutePath());
+
+    QSaveFile file(cachePath());
+    if (!file.open(QFile::WriteOnly)) {
+        qWarning() << "[UpdateManager]" << "Cannot write cache:" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(cacheObj).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void UpdateController::updateCache(QNetworkReply *reply)
+{
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 200) {
+        // validators of the previous manifest do not apply to a new one
+        m_cache.eTag.clear();
+        m_cache.lastModified.clear();
+    }
+    if (reply->hasRawHeader("ETag"))
+        m_cache.eTag = reply->rawHeader("ETag");
+    if (reply->hasRawHeader("Last-Modified"))
+        m_cache.lastModified = reply->rawHeader("Last-Modified");
+
+    static const QRegularExpression maxAgeRegExp("max-age=(\\d+)");
+    auto maxAgeMatch = maxAgeRegExp.match(QString::fromLatin1(reply->rawHeader("Cache-Control")));
+    m_cache.expires = maxAgeMatch.hasMatch()
+            ? m_clock.currentDateTime().addSecs(maxAgeMatch.captured(1).toLongLong())
+            : QDateTime();
+}
+
+void UpdateController::initializeSeed()
+{
+    m_seed = static_cast<quint32>(m_settingsController.updateSeed());
+    while (m_seed == 0) {
+        m_seed = std::random_device()();
+        m_settingsController.setUpdateSeed(static_cast<int>(m_seed));
+    }
+
+    // retries of one installation differ from check to check
+    m_random.seed(m_seed ^ static_cast<quint32>(m_clock.currentDateTime().toMSecsSinceEpoch()));
+}
+
+int UpdateController::retryDelay()
+{
+    // full jitter: anything between zero and the backoff interval
+    const qint64 interval = qMin<qint64>(static_cast<qint64>(sc_retryInterval) << qMin(m_retryCounter, 20),
+                                         sc_retryMaxInterval);
+    return std::uniform_int_distribution<int>(0, static_cast<int>(interval))(m_random);
+}
+
+void UpdateController::finishCheck(bool success)
+{
+    m_retryCounter = 0;
+    m_curReply = nullptr;
+    if (m_nam) { // not needed until next check
+        m_nam->deleteLater();
+        m_nam = nullptr;
+    }
+
+    if (success)
+        m_settingsController.setLastUpdateCheck(m_clock.currentDateTime());
+
+    const bool scheduled = m_scheduledCheck;
+    m_scheduledCheck = false;
+    if (scheduled && success) {
+        scheduleUpdateCheck(); // next one, for long sessions
+    } else if (scheduled) {
+        m_scheduleTimer.setInterval(sc_failedCheckInterval);
+        m_scheduleTimer.start();
+    }
+
+    if (success) {
+        emit checkFinished(scheduled);
+    } else {
+        emit checkError(scheduled);
+    }
+}
+
 void UpdateController::getVersionResponse()
 {
-    m_curReply = m_nam.get(QNetworkRequest(m_versionUrl));
+    if (!m_nam) {
+        m_nam = new QNetworkAccessManager(this);
+        connect(m_nam, &QNetworkAccessManager::finished,
+                this, &UpdateController::onNetworReply);
+    }
+
+    QNetworkRequest request(m_versionUrl);
+    if (!m_cache.manifest.isEmpty()) { // validators are useless without cached manifest
+        if (!m_cache.eTag.isEmpty())
+            request.setRawHeader("If-None-Match", m_cache.eTag);
+        if (!m_cache.lastModified.isEmpty())
+            request.setRawHeader("If-Modified-Since", m_cache.lastModified);
+    }
+    m_curReply = m_nam->get(request);
 }
 
 void UpdateController::setUpdateAvailable(bool updateAvailable)
@@ -170,20 +368,22 @@ void UpdateController::setPlatformDownloadUrl(QUrl platformDownloadUrl)
     emit platformDownloadUrlChanged(platformDownloadUrl);
 }
 
-void UpdateController::parseVersionResponse(const QByteArray &response)
+void UpdateController::parseVersionResponse(const QJsonObject &updateInfoObj)
 {
-    auto updateInfoObj = QJsonDocument::fromJson(response).object();
-
     auto versionString = updateInfoObj.value("version").toString();
     setNewestVersion(versionString);
 
-    auto updateAvailable = (compareVersions(QApplication::applicationVersion(), versionString) < 0);
+    auto updateAvailable = (compareVersions(QCoreApplication::applicationVersion(), versionString) < 0);
     if (updateAvailable) {
         setReleaseNotes(updateInfoObj.value("releaseNotes").toString());
 
         auto downloadUrl = updateInfoObj.value("urls").toObject()
                 .value(m_platformType).toObject().value(m_platformWordSize).toString();
         setPlatformDownloadUrl(downloadUrl);
+
+        // optional, packages without hash are downloaded with the browser
+        m_platformHash = updateInfoObj.value("sha256").toObject()
+                .value(m_platformType).toObject().value(m_platformWordSize).toString().toLatin1();
     }
     setUpdateAvailable(updateAvailable);
 }
@@ -191,23 +391,65 @@ void UpdateController::parseVersionResponse(const QByteArray &response)
 void UpdateController::onNetworReply(QNetworkReply *reply)
 {
     Q_ASSERT (reply == m_curReply);
+    reply->deleteLater();
+    m_curReply = nullptr;
 
     auto httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    auto isRedirect = (httpStatusCode == 301 || httpStatusCode == 302
+                       || httpStatusCode == 307 || httpStatusCode == 308);
     if (reply->error() == QNetworkReply::NoError
-            && (httpStatusCode == 200 || httpStatusCode == 301)) {
-        if (httpStatusCode == 301) { // redirect
-            m_versionUrl = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+            && (httpStatusCode == 200 || httpStatusCode == 304 || isRedirect)) {
+        if (isRedirect) {
+            m_versionUrl = m_versionUrl.resolved(reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl());
+            if (httpStatusCode == 301 || httpStatusCode == 308) { // permanent, remember for next checks
+                m_cache.url = m_versionUrl;
+                saveCache();
+            }
             getVersionResponse();
         } else {
-            parseVersionResponse(reply->readAll());
-            emit checkFinished();
+            if (httpStatusCode == 200) {
+                m_cache.manifest = QJsonDocument::fromJson(reply->readAll()).object();
+            } // otherwise not modified, cached manifest is valid
+            updateCache(reply);
+            saveCache();
+
+            parseVersionResponse(m_cache.manifest);
+            finishCheck(true);
         }
     } else {
         qWarning() << "[UpdateManager]" << "Network error:" << httpStatusCode << reply->errorString();
-        if (m_retryCounter++ < sc_retryMaxCount) {
-            QTimer::singleShot(sc_retryInterval, this, &UpdateController::getVersionResponse);
+        if (httpStatusCode >= 400 && m_cache.url.isValid()) { // cached redirect could be outdated
+            m_cache.url.clear();
+            m_versionUrl = m_sourceVersionUrl;
+            saveCache();
+        }
+        if (m_retryCounter < sc_retryMaxCount) {
+            m_retryTimer.setInterval(retryDelay());
+            ++m_retryCounter;
+            m_retryTimer.start();
         } else {
-            emit checkError();
+            finishCheck(false);
         }
     }
 }
+
+void UpdateController::onScheduledCheck()
+{
+    if (m_curReply || m_retryTimer.isActive())
+        return; // already checking
+
+    m_scheduledCheck = true;
+    startCheck();
+}
+
+void UpdateController::onDownloadFinished(const QString &filePath)
+{
+    emit downloadFinished(filePath);
+    QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
+}
+
+void UpdateController::onDownloadError(const QString &errorString)
+{
+    emit downloadError(errorString);
+    QDesktopServices::openUrl(m_platformDownloadUrl); // let the browser try
+}
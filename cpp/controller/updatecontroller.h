@@ -24,14 +24,38 @@
 #define UPDATEMANAGER_H
 
 #include <QObject>
-#include <QNetworkAccessManager>
 #include <QUrl>
+#include <QDateTime>
+#include <QJsonObject>
+#include <random>
 
+#include "utility/clock.h"
+#include "workers/updatedownloader.h"
+
+class QNetworkAccessManager;
 class QNetworkReply;
 class SettingsController;
 
 /*!
  * \brief Class to check availability of new software version.
+ *
+ * The parsed version manifest is cached on disk together with
+ * its validators (ETag and Last-Modified), so checks are conditional
+ * requests answered mostly with 304 Not Modified. No request is sent
+ * while the manifest is fresh (Cache-Control max-age). Target of
+ * a permanent redirect is cached too and requested directly.
+ *
+ * To spread requests of many installations over time, scheduled
+ * checks are delayed by a per-installation random amount and failed
+ * checks are retried with exponential backoff and full jitter.
+ *
+ * Scheduled checks run at most once a day and never right after
+ * startup. Network access manager is created for a check only
+ * and destroyed when the check is finished.
+ *
+ * Package with a hash published in the version manifest is downloaded
+ * in the background and opened when verified. Other packages are
+ * downloaded with the browser.
  */
 class UpdateController final : public QObject
 {
@@ -43,6 +67,7 @@ class UpdateController final : public QObject
 
 public:
     UpdateController(SettingsController &settingsController, const QUrl &versionUrl, QObject *parent = 0);
+    UpdateController(SettingsController &settingsController, const QUrl &versionUrl, Clock &clock, QObject *parent = 0);
 
     bool updateAvailable() const;
     QString newestVersion() const;
@@ -57,11 +82,20 @@ public slots:
      * \brief Check if new version of software is available.
      */
     void checkUpdateAvailable();
+    /*!
+     * \brief Schedules next check for update, a day after the last one,
+     * but not before the startup delay of this installation.
+     */
+    void scheduleUpdateCheck();
 
     /*!
      * \brief Downloads the newest package.
      */
     void download();
+    /*!
+     * \brief Stops background download, it is resumed by next download().
+     */
+    void cancelDownload();
     /*!
      * \brief Postpones download (remind me later).
      */
@@ -77,16 +111,49 @@ signals:
     void releaseNotesChanged(QString releaseNotes) const;
     void platformDownloadUrlChanged(QUrl platformDownloadUrl) const;
 
-    void checkFinished() const;
-    void checkError() const;
+    /*!
+     * \param scheduled   true if check was scheduled, not requested
+     */
+    void checkFinished(bool scheduled) const;
+    void checkError(bool scheduled) const;
+
+    /*!
+     * \brief Emitted when the package is downloaded in the background,
+     * followed by downloadFinished() or downloadError().
+     */
+    void downloadStarted() const;
+    void downloadProgress(qint64 received, qint64 total) const;
+    void downloadFinished(const QString &filePath) const;
+    void downloadError(const QString &errorString) const;
 
 private:
-    static const int sc_retryInterval = 1000; // ms
-    static const int sc_retryMaxCount = 5;
+    static const int sc_retryInterval = 2000; // ms, base of the backoff
+    static const int sc_retryMaxInterval = 5*60*1000; // ms, cap of the backoff
+    static const int sc_retryMaxCount = 8;
+    static const int sc_startupDelay = 60*1000;       // ms, minimal delay after startup
+    static const int sc_startupSpread = 10*60*1000;   // ms, maximal additional startup delay
+    static const int sc_checkInterval = 1;  // days, between scheduled checks
+    static const int sc_failedCheckInterval = 60*60*1000;  // ms, after failed scheduled check
+    static const int sc_downloadRateLimit = 512*1024;   // bytes per second
     static const int sc_postponeInterval = 7;   // days
+    static const QLatin1String sc_cacheFileName;
+
+    /*!
+     * \brief Cached version manifest with validators of its response.
+     */
+    struct VersionCache {
+        QUrl sourceUrl;     //! requested url, before redirects
+        QUrl url;           //! permanent redirect target of the source url (if any)
+        QByteArray eTag;
+        QByteArray lastModified;
+        QDateTime expires;  //! manifest is fresh until then
+        QJsonObject manifest;
+    };
 
     SettingsController &m_settingsController;
+    Clock &m_clock;
 
+    const QUrl m_sourceVersionUrl;  //! url given on construction
     QUrl m_versionUrl;
     QString m_platformType; // os
     QString m_platformWordSize; // 32bit or 64bit
@@ -95,15 +162,50 @@ private:
     QString m_newestVersion;
     QString m_releaseNotes;
     QUrl m_platformDownloadUrl;
+    QByteArray m_platformHash;  //! SHA-256 of the package (hex), empty if not published
 
-    QNetworkAccessManager m_nam;
+    QNetworkAccessManager *m_nam = nullptr;   //! exists during a check only
     QNetworkReply *m_curReply = nullptr;
+    bool m_scheduledCheck = false;  //! true if current check was scheduled
+    ClockTimer m_retryTimer;
     int m_retryCounter = 0;
+    ClockTimer m_scheduleTimer; //! triggers scheduled check
+
+    quint32 m_seed;         //! random per installation
+    std::mt19937 m_random;  //! used for retry jitter
+
+    VersionCache m_cache;
+
+    UpdateDownloader m_downloader;
 
     void checkPlatformInfo();
+    /*!
+     * \brief Reads seed of this installation, generates it on first use.
+     */
+    void initializeSeed();
+    /*!
+     * \brief Returns random delay of the next retry (in ms),
+     * up to exponentially growing and capped interval.
+     */
+    int retryDelay();
+
+    QString cachePath() const;
+    void loadCache();
+    void saveCache() const;
+    /*!
+     * \brief Updates manifest freshness and validators from reply headers.
+     * A new manifest (200) replaces validators, 304 updates the sent ones.
+     */
+    void updateCache(QNetworkReply *reply);
+
+    /*!
+     * \brief Ends current check and releases network resources.
+     */
+    void finishCheck(bool success);
+    void startCheck();
 
     void getVersionResponse();
-    void parseVersionResponse(const QByteArray &response);
+    void parseVersionResponse(const QJsonObject &updateInfoObj);
 
 private slots:
     void setUpdateAvailable(bool updateAvailable);
@@ -112,6 +214,9 @@ private slots:
     void setPlatformDownloadUrl(QUrl platformDownloadUrl);
 
     void onNetworReply(QNetworkReply *reply);
+    void onScheduledCheck();
+    void onDownloadFinished(const QString &filePath);
+    void onDownloadError(const QString &errorString);
 };
 
 #endif // UPDATEMANAGER_H
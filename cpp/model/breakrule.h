@@ -0,0 +1,67 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef BREAKRULE_H
+#define BREAKRULE_H
+
+#include <QString>
+#include <QDataStream>
+
+/*!
+ * \brief Additional break rule (e.g. micro-break or lunch break).
+ *
+ * Rule requests a break of given duration after each interval
+ * of work time. All values are in seconds.
+ */
+struct BreakRule {
+    QString name;
+    int interval = 0;       //! work time between breaks
+    int duration = 0;       //! break duration
+    int postponeTime = 0;   //! duration of one postpone
+
+    bool operator==(const BreakRule &other) const
+    {
+        return (name == other.name && interval == other.interval &&
+                duration == other.duration && postponeTime == other.postponeTime);
+    }
+    bool operator!=(const BreakRule &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+inline QDataStream &operator<<(QDataStream &stream, const BreakRule &rule)
+{
+    return stream << rule.name << qint32(rule.interval) << qint32(rule.duration) << qint32(rule.postponeTime);
+}
+
+inline QDataStream &operator>>(QDataStream &stream, BreakRule &rule)
+{
+    qint32 interval = 0, duration = 0, postponeTime = 0;
+    stream >> rule.name >> interval >> duration >> postponeTime;
+    rule.interval = interval;
+    rule.duration = duration;
+    rule.postponeTime = postponeTime;
+    return stream;
+}
+
+#endif // BREAKRULE_H
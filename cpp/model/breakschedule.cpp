@@ -0,0 +1,198 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "breakschedule.h"
+
+const int BreakSchedule::sc_noRule;
+
+void BreakSchedule::setRules(const QList<BreakRule> &rules, qint64 workTime)
+{
+    m_rules = rules;
+    reset(workTime);
+}
+
+const QList<BreakRule> &BreakSchedule::rules() const
+{
+    return m_rules;
+}
+
+const BreakRule &BreakSchedule::rule(int index) const
+{
+    return m_rules.at(index);
+}
+
+bool BreakSchedule::isEmpty() const
+{
+    return m_rules.isEmpty();
+}
+
+int BreakSchedule::nextRule() const
+{
+    return m_heap.isEmpty() ? sc_noRule : m_heap.first();
+}
+
+qint64 BreakSchedule::nextDeadline() const
+{
+    return m_heap.isEmpty() ? -1 : deadline(m_heap.first());
+}
+
+void BreakSchedule::request(int index, qint64 workTime)
+{
+    Entry &entry = m_entries[index];
+    if (entry.requested) {
+        return;
+    }
+
+    entry.requested = true;
+    entry.lastRequest = workTime;
+    remove(index);
+}
+
+void BreakSchedule::postponeRequested(qint64 workTime)
+{
+    for (int index = 0; index < m_rules.count(); ++index) {
+        Entry &entry = m_entries[index];
+        if (!entry.requested) {
+            continue;
+        }
+
+        entry.postponeDuration += (workTime - entry.lastRequest) + m_rules.at(index).postponeTime*1000LL;
+        entry.requested = false;
+        insert(index);
+    }
+}
+
+void BreakSchedule::takeBreak(int duration, qint64 workTime)
+{
+    for (int index = 0; index < m_rules.count(); ++index) {
+        if (m_rules.at(index).duration > duration) {
+            continue;
+        }
+
+        Entry &entry = m_entries[index];
+        entry = Entry();
+        entry.lastBreak = workTime;
+        if (m_positions.at(index) < 0) {
+            insert(index);
+        } else {
+            update(index);
+        }
+    }
+}
+
+void BreakSchedule::reset(qint64 workTime)
+{
+    const int count = m_rules.count();
+    m_entries.fill(Entry(), count);
+    m_positions.fill(-1, count);
+    m_heap.clear();
+    m_heap.reserve(count);
+
+    for (int index = 0; index < count; ++index) {
+        m_entries[index].lastBreak = workTime;
+        insert(index);
+    }
+}
+
+qint64 BreakSchedule::deadline(int index) const
+{
+    const Entry &entry = m_entries.at(index);
+    return entry.lastBreak + m_rules.at(index).interval*1000LL + entry.postponeDuration;
+}
+
+void BreakSchedule::insert(int index)
+{
+    m_positions[index] = m_heap.count();
+    m_heap.append(index);
+    siftUp(m_heap.count() - 1);
+}
+
+void BreakSchedule::remove(int index)
+{
+    const int position = m_positions.at(index);
+    if (position < 0) {
+        return;
+    }
+
+    swap(position, m_heap.count() - 1);
+    m_heap.removeLast();
+    m_positions[index] = -1;
+
+    if (position < m_heap.count()) {
+        siftUp(position);
+        siftDown(position);
+    }
+}
+
+void BreakSchedule::update(int index)
+{
+    const int position = m_positions.at(index);
+    siftUp(position);
+    siftDown(position);
+}
+
+void BreakSchedule::siftUp(int position)
+{
+    while (position > 0) {
+        const int parent = (position - 1)/2;
+        if (deadline(m_heap.at(parent)) <= deadline(m_heap.at(position))) {
+            break;
+        }
+
+        swap(position, parent);
+        position = parent;
+    }
+}
+
+void BreakSchedule::siftDown(int position)
+{
+    const int count = m_heap.count();
+    forever {
+        int smallest = position;
+        for (int child = 2*position + 1; child <= 2*position + 2 && child < count; ++child) {
+            if (deadline(m_heap.at(child)) < deadline(m_heap.at(smallest))) {
+                smallest = child;
+            }
+        }
+
+        if (smallest == position) {
+            break;
+        }
+
+        swap(position, smallest);
+        position = smallest;
+    }
+}
+
+void BreakSchedule::swap(int position1, int position2)
+{
+    if (position1 == position2) {
+        return;
+    }
+
+    const int index1 = m_heap.at(position1);
+    const int index2 = m_heap.at(position2);
+    m_heap[position1] = index2;
+    m_heap[position2] = index1;
+    m_positions[index1] = position2;
+    m_positions[index2] = position1;
+}
@@ -0,0 +1,117 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef BREAKSCHEDULE_H
+#define BREAKSCHEDULE_H
+
+#include <QList>
+#include <QVector>
+
+#include "breakrule.h"
+
+/*!
+ * \brief Timeline of additional break rules.
+ *
+ * Deadlines are expressed in total work time (in ms), so they
+ * do not change while work is paused or time is adjusted.
+ * Rules are kept in a binary min-heap ordered by deadlines,
+ * the nearest one is available in O(1) and each change
+ * of a rule deadline costs O(log n).
+ *
+ * Rule which break has been requested leaves the timeline
+ * until the request is answered (postponed or break taken).
+ */
+class BreakSchedule final
+{
+public:
+    static const int sc_noRule = -1;
+
+    /*!
+     * \brief Replaces rules, all of them start counting from given work time.
+     */
+    void setRules(const QList<BreakRule> &rules, qint64 workTime);
+    const QList<BreakRule> &rules() const;
+    const BreakRule &rule(int index) const;
+    bool isEmpty() const;
+
+    /*!
+     * \brief Returns index of the rule with the nearest deadline.
+     * sc_noRule if no rule is waiting.
+     */
+    int nextRule() const;
+    /*!
+     * \brief Returns work time of the nearest deadline (in ms).
+     * Negative value if no rule is waiting.
+     */
+    qint64 nextDeadline() const;
+
+    /*!
+     * \brief Removes rule from timeline as its break has been requested.
+     *
+     * \param index     rule index
+     * \param workTime  current total work time (in ms)
+     */
+    void request(int index, qint64 workTime);
+    /*!
+     * \brief Postpones breaks of all requested rules,
+     * each by its own postpone time.
+     *
+     * \param workTime  current total work time (in ms)
+     */
+    void postponeRequested(qint64 workTime);
+    /*!
+     * \brief Restarts all rules satisfied by a break of given duration.
+     *
+     * \param duration  break duration (in secs)
+     * \param workTime  current total work time (in ms)
+     */
+    void takeBreak(int duration, qint64 workTime);
+    /*!
+     * \brief Restarts all rules from given work time.
+     */
+    void reset(qint64 workTime);
+
+private:
+    struct Entry {
+        qint64 lastBreak = 0;           //! work time of last break (ms)
+        qint64 postponeDuration = 0;    //! sum of postpones of current break (ms)
+        qint64 lastRequest = 0;         //! work time of last request (ms)
+        bool requested = false;         //! true if waiting for answer
+    };
+
+    QList<BreakRule> m_rules;
+    QVector<Entry> m_entries;   //! state of each rule
+    QVector<int> m_heap;        //! waiting rules indexes ordered as min-heap
+    QVector<int> m_positions;   //! heap position of each rule (-1 if not waiting)
+
+    qint64 deadline(int index) const;
+
+    void insert(int index);
+    void remove(int index);
+    void update(int index);
+
+    void siftUp(int position);
+    void siftDown(int position);
+    void swap(int position1, int position2);
+};
+
+#endif // BREAKSCHEDULE_H
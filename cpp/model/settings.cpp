@@ -22,198 +22,483 @@
 
 #include "settings.h"
 
-#include <QDateTime>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 
-const QLatin1String Settings::sc_systemGroupName = QLatin1String("system");
-const QLatin1String Settings::sc_logicGroupName = QLatin1String("logic");
-const QLatin1String Settings::sc_updateGroupName = QLatin1String("update");
-const QLatin1String Settings::sc_viewGroupName = QLatin1String("view");
+const int Settings::sc_flushDelay = 2*1000;  //! 2 s
 
-const QLatin1String Settings::sc_trayAvailableKey = QLatin1String("trayAvailable");
-const QLatin1String Settings::sc_showTrayInfoKey = QLatin1String("showTrayInfo");
+const quint32 Settings::sc_binaryMagic = 0x5253544F;    //! "RSTO"
+const quint16 Settings::sc_binaryVersion = 1;
 
-const QLatin1String Settings::sc_breakDurationKey = QLatin1String("breakDuration");
-const QLatin1String Settings::sc_breakIntervalKey = QLatin1String("breakInterval");
-const QLatin1String Settings::sc_workTimeKey = QLatin1String("workTime");
-const QLatin1String Settings::sc_postponeTimeKey = QLatin1String("postponeTime");
-const QLatin1String Settings::sc_autoStartKey = QLatin1String("autoStart");
-const QLatin1String Settings::sc_autoHideKey = QLatin1String("autoHide");
-const QLatin1String Settings::sc_hideOnCloseKey = QLatin1String("hideOnClose");
+template <typename... S>
+void Settings::readDefaults(Values &values, std::tuple<S...> *) const
+{
+    const int expand[] = { 0, (std::get<Setting::IndexOf<S>::value>(values) = S::defaultValue(), 0)... };
+    Q_UNUSED(expand);
+}
+
+template <typename... S>
+void Settings::resetValues(std::tuple<S...> *)
+{
+    const int expand[] = { 0, (setValue<S>(S::defaultValue()), 0)... };
+    Q_UNUSED(expand);
+}
 
-const QLatin1String Settings::sc_updateVersionKey = QLatin1String("updateVersion");
-const QLatin1String Settings::sc_nextUpdateCheckKey = QLatin1String("nextUpdateCheck");
+template <typename... S>
+void Settings::readIni(Values &values, std::tuple<S...> *) const
+{
+    const int expand[] = { 0, (std::get<Setting::IndexOf<S>::value>(values) = read(S::path(), S::defaultValue()), 0)... };
+    Q_UNUSED(expand);
+}
+
+template <typename... S>
+void Settings::writeIni(std::tuple<S...> *)
+{
+    const int expand[] = { 0, (m_dirty.test(Setting::IndexOf<S>::value) ? (write(S::path(), value<S>()), 0) : 0)... };
+    Q_UNUSED(expand);
+}
 
-const QLatin1String Settings::sc_windowPositionXKey = QLatin1String("window-x");
-const QLatin1String Settings::sc_windowPositionYKey = QLatin1String("window-y");
-const QLatin1String Settings::sc_windowWidthKey = QLatin1String("window-width");
-const QLatin1String Settings::sc_windowHeightKey = QLatin1String("window-height");
-const QLatin1String Settings::sc_applicationColorKey = QLatin1String("mainColor");
+template <typename... S>
+Settings::Changes Settings::update(const Values &values, std::tuple<S...> *)
+{
+    Changes changes;
+    const int expand[] = { 0, (changes.set(Setting::IndexOf<S>::value, updateValue<S>(values)), 0)... };
+    Q_UNUSED(expand);
+    return changes;
+}
 
-const int Settings::sc_defaultBreakDuration = 10*60;  //! 10 min
-const int Settings::sc_defaultBreakInterval = 45*60; //! 45 min
-const int Settings::sc_defaultWorkTime = 8*60*60;  //! 8 h
-const int Settings::sc_defaultPostponeTime = 5*60;   //! 5 min
+template <typename S>
+bool Settings::updateValue(const Values &values)
+{
+    constexpr int index = Setting::IndexOf<S>::value;
+    if (m_dirty.test(index)) // local change is newer
+        return false;
 
-const QSize Settings::sc_defaultWindowSize = { 400, 200 };  // px
-QColor Settings::sc_defaultApplicationColor;
+    const auto &stored = std::get<index>(values);
+    auto &slot = std::get<index>(m_values);
+    if (slot == stored)
+        return false;
 
-Settings::Settings(const QString organization, const QString name)
-    : m_settings(QSettings::UserScope, organization, name)
-{}
+    slot = stored;
+    return true;
+}
 
-bool Settings::trayAvailable() const
+template <typename... S>
+Settings::Changes Settings::differences(const Values &values1, const Values &values2, std::tuple<S...> *)
 {
-    return value(sc_systemGroupName, sc_trayAvailableKey, false).toBool();
+    Changes changes;
+    const int expand[] = { 0, (changes.set(Setting::IndexOf<S>::value,
+                                           std::get<Setting::IndexOf<S>::value>(values1) != std::get<Setting::IndexOf<S>::value>(values2)), 0)... };
+    Q_UNUSED(expand);
+    return changes;
 }
 
-void Settings::setTrayAvailable(bool available)
+template <typename... S>
+void Settings::readRecord(const QByteArray &key, const QByteArray &data, Values &values, std::tuple<S...> *) const
 {
-    setValue(sc_systemGroupName, sc_trayAvailableKey, available);
+    // unknown keys (e.g. removed settings) are skipped, a record fills one slot at most
+    bool found = false;
+    const int expand[] = { 0, (!found && key == S::key() ? (found = true, readRecordValue(data, std::get<Setting::IndexOf<S>::value>(values)), 0) : 0)... };
+    Q_UNUSED(expand);
 }
 
-bool Settings::showTrayInfo() const
+template <typename... S>
+void Settings::writeRecords(QDataStream &stream, std::tuple<S...> *) const
 {
-    return value(sc_systemGroupName, sc_showTrayInfoKey, true).toBool();
+    stream << quint32(sizeof...(S));
+    const int expand[] = { 0, (stream << QByteArray(S::key()) << recordData(value<S>()), 0)... };
+    Q_UNUSED(expand);
 }
 
-void Settings::setShowTrayInfo(bool show)
+template <typename T>
+void Settings::readRecordValue(const QByteArray &data, T &value)
 {
-    setValue(sc_systemGroupName, sc_showTrayInfoKey, show);
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    T recorded;
+    stream >> recorded;
+    if (stream.status() == QDataStream::Ok && stream.atEnd()) // otherwise type of the setting has changed
+        value = recorded;
 }
 
-int Settings::breakDuration() const
+void Settings::readRecordValue(const QByteArray &data, QList<BreakRule> &value)
 {
-    return value(sc_logicGroupName, sc_breakDurationKey, sc_defaultBreakDuration).toInt();
+    QList<BreakRule> recorded = value;
+    readRecordValue<QList<BreakRule>>(data, recorded);
+
+    // same validation as for INI file
+    value.clear();
+    for (const BreakRule &rule : recorded) {
+        if (rule.interval <= 0 || rule.duration <= 0) {
+            qWarning() << "[Settings] Invalid break rule:" << rule.name;
+            continue;
+        }
+        value.append(rule);
+    }
 }
-void Settings::setBreakDuration(int duration)
+
+template <typename T>
+QByteArray Settings::recordData(const T &value)
 {
-    setValue(sc_logicGroupName, sc_breakDurationKey, duration);
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_5);
+    stream << value;
+    return data;
 }
 
-int Settings::breakInterval() const
+Settings::Settings(const QString organization, const QString name, Backend backend)
+    : m_settings(QSettings::UserScope, organization, name), m_backend(backend)
 {
-    return value(sc_logicGroupName, sc_breakIntervalKey, sc_defaultBreakInterval).toInt();
+    if (m_backend == Backend::Binary) {
+        // native settings are not a file on every platform (e.g. registry on Windows)
+        const QSettings iniSettings(QSettings::IniFormat, QSettings::UserScope, organization, name);
+        m_binaryFilePath = QFileInfo(iniSettings.fileName()).absolutePath() + '/' + name + ".dat";
+
+        readDefaults(m_values, static_cast<Setting::Schema*>(nullptr));
+        if (!readBinary(m_values)) { // migrate from INI file
+            readIni(m_values, static_cast<Setting::Schema*>(nullptr));
+            writeBinary();
+        }
+    } else {
+        readIni(m_values, static_cast<Setting::Schema*>(nullptr));
+    }
+    m_fileHash = fileHash();
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(sc_flushDelay);
+    connect(&m_flushTimer, &QTimer::timeout, this, &Settings::flush);
+    if (QCoreApplication::instance())
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Settings::flush);
+
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &Settings::reload);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &Settings::reload);
+    watchFile();
 }
-void Settings::setBreakInterval(int interval)
+
+Settings::~Settings()
 {
-    setValue(sc_logicGroupName, sc_breakIntervalKey, interval);
+    flush();
 }
 
-int Settings::workTime() const
+Settings::Backend Settings::backend() const
 {
-    return value(sc_logicGroupName, sc_workTimeKey, sc_defaultWorkTime).toInt();
+    return m_backend;
 }
-void Settings::setWorkTime(int time)
+
+void Settings::resetValues()
 {
-    setValue(sc_logicGroupName, sc_workTimeKey, time);
+    resetValues(static_cast<Setting::Schema*>(nullptr));
 }
 
-int Settings::postponeTime() const
+void Settings::beginTransaction()
 {
-    return value(sc_logicGroupName, sc_postponeTimeKey, sc_defaultPostponeTime).toInt();
+    if (m_inTransaction) {
+        qWarning() << "[Settings]" << "Transaction already started";
+        return;
+    }
+
+    m_inTransaction = true;
+    m_transactionValues = m_values;
+    m_transactionDirty = m_dirty;
 }
-void Settings::setPostponeTime(int time)
+
+void Settings::commitTransaction()
 {
-    setValue(sc_logicGroupName, sc_postponeTimeKey, time);
+    if (!m_inTransaction)
+        return;
+
+    m_inTransaction = false;
+    const auto changes = differences(m_transactionValues, m_values, static_cast<Setting::Schema*>(nullptr));
+    if (changes.any()) {
+        flush(); // in one write
+        emit valuesChanged(changes);
+    } else {
+        m_dirty = m_transactionDirty; // values were changed back
+        if (m_dirty.any()) // changes made before the transaction are still pending
+            m_flushTimer.start();
+    }
+
+    if (m_reloadPending)
+        reload();
 }
 
-bool Settings::autoStart() const
+void Settings::rollbackTransaction()
 {
-    return value(sc_logicGroupName, sc_autoStartKey, false).toBool();
+    if (!m_inTransaction)
+        return;
+
+    m_inTransaction = false;
+    m_values = m_transactionValues;
+    m_dirty = m_transactionDirty;
+    if (m_dirty.any()) // changes made before the transaction are still pending
+        m_flushTimer.start();
+
+    if (m_reloadPending)
+        reload();
 }
-void Settings::setAutoStart(bool start)
+
+bool Settings::isInTransaction() const
 {
-    setValue(sc_logicGroupName, sc_autoStartKey, start);
+    return m_inTransaction;
 }
 
-bool Settings::autoHide() const
+void Settings::flush()
 {
-    return value(sc_logicGroupName, sc_autoHideKey, false).toBool();
+    m_flushTimer.stop();
+    if (m_dirty.none() || m_inTransaction) // staged values are written on commit
+        return;
+
+    if (m_backend == Backend::Binary) {
+        writeBinary();
+    } else {
+        writeIni(static_cast<Setting::Schema*>(nullptr));
+        m_settings.sync();
+    }
+    m_dirty.reset();
+    ++m_flushCount;
+
+    m_fileHash = fileHash(); // own write is not an external change
+    watchFile();
 }
 
-void Settings::setAutoHide(bool hide)
+int Settings::savedWrites() const
 {
-    setValue(sc_logicGroupName, sc_autoHideKey, hide);
+    return m_writeCount - m_flushCount - (m_dirty.any() ? 1 : 0);
 }
 
-bool Settings::hideOnClose() const
+void Settings::reload()
 {
-    return value(sc_logicGroupName, sc_hideOnCloseKey, true).toBool();
+    watchFile();
+
+    m_reloadPending = m_inTransaction;
+    if (m_reloadPending) // values would be mixed with staged ones
+        return;
+
+    const auto hash = fileHash();
+    if (hash == m_fileHash) // e.g. touched, own write or other file in directory
+        return;
+
+    m_fileHash = hash;
+
+    Values values;
+    if (m_backend == Backend::Binary) {
+        readDefaults(values, static_cast<Setting::Schema*>(nullptr));
+        if (!readBinary(values))
+            return;
+    } else {
+        m_settings.sync(); // make QSettings read the file again
+        readIni(values, static_cast<Setting::Schema*>(nullptr));
+    }
+    const auto changes = update(values, static_cast<Setting::Schema*>(nullptr));
+    if (changes.any())
+        emit valuesChanged(changes);
 }
 
-void Settings::setHideOnClose(bool hide)
+void Settings::markDirty(int index)
 {
-    setValue(sc_logicGroupName, sc_hideOnCloseKey, hide);
+    m_dirty.set(index);
+    ++m_writeCount;
+    if (!m_inTransaction)
+        m_flushTimer.start();
 }
 
-QString Settings::updateVersion() const
+QString Settings::filePath() const
 {
-    return value(sc_updateGroupName, sc_updateVersionKey).toString();
+    return (m_backend == Backend::Binary) ? m_binaryFilePath : m_settings.fileName();
 }
 
-void Settings::setUpdateVersion(const QString &version)
+QByteArray Settings::fileHash() const
 {
-    setValue(sc_updateGroupName, sc_updateVersionKey, version);
+    QFile file(filePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1);
+}
+
+void Settings::watchFile()
+{
+    const QString filePath = this->filePath();
+    const QString dirPath = QFileInfo(filePath).absolutePath();
+
+    if (QFile::exists(filePath) && !m_watcher.files().contains(filePath))
+        m_watcher.addPath(filePath);
+    if (QFile::exists(dirPath) && !m_watcher.directories().contains(dirPath))
+        m_watcher.addPath(dirPath);
 }
 
-QDateTime Settings::nextUpdateCheck() const
+bool Settings::readBinary(Values &values) const
 {
-    return QDateTime::fromString(value(sc_updateGroupName, sc_nextUpdateCheckKey).toString(), Qt::ISODate);
+    QFile file(m_binaryFilePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = file.size();
+    uchar *memory = file.map(0, size);
+    if (!memory) {
+        qWarning() << "[Settings]" << "Cannot map settings file:" << file.errorString();
+        return false;
+    }
+
+    // header: magic, version, payload size, payload checksum
+    const QByteArray content = QByteArray::fromRawData(reinterpret_cast<const char*>(memory), size);
+    QDataStream stream(content);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    quint32 magic = 0, payloadSize = 0;
+    quint16 version = 0, checksum = 0;
+    stream >> magic >> version >> payloadSize >> checksum;
+
+    const int headerSize = sizeof(magic) + sizeof(version) + sizeof(payloadSize) + sizeof(checksum);
+    bool valid = (stream.status() == QDataStream::Ok && magic == sc_binaryMagic &&
+                  version == sc_binaryVersion && payloadSize == size - headerSize &&
+                  checksum == qChecksum(content.constData() + headerSize, payloadSize));
+
+    if (valid) {
+        quint32 count = 0;
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            QByteArray key, data;
+            stream >> key >> data;
+            readRecord(key, data, values, static_cast<Setting::Schema*>(nullptr));
+        }
+        valid = (stream.status() == QDataStream::Ok);
+    }
+
+    file.unmap(memory);
+    if (!valid)
+        qWarning() << "[Settings]" << "Invalid settings file:" << m_binaryFilePath;
+    return valid;
 }
 
-void Settings::setNextUpdateCheck(const QDateTime &checkDate)
+bool Settings::writeBinary()
 {
-    setValue(sc_updateGroupName, sc_nextUpdateCheckKey, checkDate.toString(Qt::ISODate));
+    QByteArray payload;
+    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+    payloadStream.setVersion(QDataStream::Qt_5_5);
+    writeRecords(payloadStream, static_cast<Setting::Schema*>(nullptr));
+
+    QDir().mkpath(QFileInfo(m_binaryFilePath).absolutePath());
+    QSaveFile file(m_binaryFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[Settings]" << "Cannot write settings file:" << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+    stream << sc_binaryMagic << sc_binaryVersion << quint32(payload.size())
+           << quint16(qChecksum(payload.constData(), payload.size()));
+    stream.writeRawData(payload.constData(), payload.size());
+
+    return file.commit(); // replaces previous file atomically
 }
 
-QPoint Settings::windowPosition() const
+template <typename T>
+T Settings::read(const QString &path, const T &defaultValue) const
 {
-    return { value(sc_viewGroupName, sc_windowPositionXKey, -1).toInt(),
-                value(sc_viewGroupName, sc_windowPositionYKey, -1).toInt() };
+    return m_settings.value(path, defaultValue).template value<T>();
 }
 
-void Settings::setWindowPosition(const QPoint &position)
+QPoint Settings::read(const QString &path, const QPoint &defaultValue) const
 {
-    setValue(sc_viewGroupName, sc_windowPositionXKey, position.x());
-    setValue(sc_viewGroupName, sc_windowPositionYKey, position.y());
+    return { m_settings.value(path + "-x", defaultValue.x()).toInt(),
+                m_settings.value(path + "-y", defaultValue.y()).toInt() };
 }
 
-QSize Settings::windowSize() const
+QSize Settings::read(const QString &path, const QSize &defaultValue) const
 {
-    return { value(sc_viewGroupName, sc_windowWidthKey, sc_defaultWindowSize.width()).toInt(),
-                value(sc_viewGroupName, sc_windowHeightKey, sc_defaultWindowSize.height()).toInt() };
+    return { m_settings.value(path + "-width", defaultValue.width()).toInt(),
+                m_settings.value(path + "-height", defaultValue.height()).toInt() };
 }
 
-void Settings::setWindowSize(const QSize &size)
+QColor Settings::read(const QString &path, const QColor &defaultValue) const
 {
-    setValue(sc_viewGroupName, sc_windowWidthKey, size.width());
-    setValue(sc_viewGroupName, sc_windowHeightKey, size.height());
+    const QString name = m_settings.value(path).toString();
+    return name.isEmpty() ? defaultValue : QColor(name);
 }
 
-QColor Settings::applicationColor() const
+QDateTime Settings::read(const QString &path, const QDateTime &defaultValue) const
 {
-    return value(sc_viewGroupName, sc_applicationColorKey, sc_defaultApplicationColor).toString();
+    const QString date = m_settings.value(path).toString();
+    return date.isEmpty() ? defaultValue : QDateTime::fromString(date, Qt::ISODate);
 }
 
-void Settings::setApplicationColor(const QColor &color)
+QList<BreakRule> Settings::read(const QString &path, const QList<BreakRule> &defaultValue) const
 {
-    setValue(sc_viewGroupName, sc_applicationColorKey, color.name(QColor::HexRgb));
+    // same layout as QSettings::beginReadArray(), which is not available for const object
+    const QString prefix = path + '/';
+    if (!m_settings.contains(prefix + "size"))
+        return defaultValue;
+
+    const int count = m_settings.value(prefix + "size", 0).toInt();
+
+    QList<BreakRule> rules;
+    for (int i = 1; i <= count; ++i) {
+        const QString rulePrefix = prefix + QString::number(i) + '/';
+
+        BreakRule rule;
+        rule.name = m_settings.value(rulePrefix + "name").toString();
+        rule.interval = m_settings.value(rulePrefix + "interval", 0).toInt();
+        rule.duration = m_settings.value(rulePrefix + "duration", 0).toInt();
+        rule.postponeTime = m_settings.value(rulePrefix + "postponeTime", Setting::PostponeTime::defaultValue()).toInt();
+
+        if (rule.interval <= 0 || rule.duration <= 0) {
+            qWarning() << "[Settings] Invalid break rule:" << rule.name;
+            continue;
+        }
+        rules.append(rule);
+    }
+    return rules;
 }
 
-void Settings::setDefaultApplicationColor(const QColor &value)
+template <typename T>
+void Settings::write(const QString &path, const T &value)
 {
-    sc_defaultApplicationColor = value;
+    m_settings.setValue(path, value);
 }
 
-void Settings::setValue(const QString &groupName, const QString &key, const QVariant &value)
+void Settings::write(const QString &path, const QPoint &value)
 {
-    m_settings.beginGroup(groupName);
-    m_settings.setValue(key, value);
-    m_settings.endGroup();
+    m_settings.setValue(path + "-x", value.x());
+    m_settings.setValue(path + "-y", value.y());
 }
 
-QVariant Settings::value(const QString &groupName, const QString &key, const QVariant &defaultValue) const
+void Settings::write(const QString &path, const QSize &value)
 {
-    return m_settings.value(groupName + '/' + key, defaultValue);
+    m_settings.setValue(path + "-width", value.width());
+    m_settings.setValue(path + "-height", value.height());
 }
 
+void Settings::write(const QString &path, const QColor &value)
+{
+    m_settings.setValue(path, value.name(QColor::HexRgb));
+}
+
+void Settings::write(const QString &path, const QDateTime &value)
+{
+    m_settings.setValue(path, value.toString(Qt::ISODate));
+}
+
+void Settings::write(const QString &path, const QList<BreakRule> &value)
+{
+    m_settings.remove(path);
+    m_settings.beginWriteArray(path, value.count());
+    for (int i = 0; i < value.count(); ++i) {
+        const BreakRule &rule = value.at(i);
+
+        m_settings.setArrayIndex(i);
+        m_settings.setValue("name", rule.name);
+        m_settings.setValue("interval", rule.interval);
+        m_settings.setValue("duration", rule.duration);
+        m_settings.setValue("postponeTime", rule.postponeTime);
+    }
+    m_settings.endArray();
+}
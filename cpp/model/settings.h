@@ -25,216 +25,255 @@
 
 #include <QObject>
 #include <QSettings>
-#include <QPoint>
-#include <QSize>
-#include <QColor>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QDataStream>
+
+#include <bitset>
+
+#include "settingsschema.h"
 
 /*!
  * \brief Utility class to access application settings.
+ *
+ * Settings are described by the schema (\see Setting namespace)
+ * and accessed by their types, e.g. value<Setting::BreakDuration>().
+ *
+ * All values are read once on construction and kept in memory,
+ * so reading does not touch QSettings. Changed values are written
+ * behind, in one batch when no change came for a while (and on quit).
+ *
+ * Settings file is watched, when it is changed by another process
+ * values are read again and valueChanged() is emitted only for
+ * settings which differ from cached values.
+ *
+ * Values are stored either by QSettings (INI file) or in a compact
+ * binary file, which is memory mapped for reading and replaced
+ * atomically on write. Binary file is created from the INI values
+ * when it does not exist yet.
+ *
+ * Several changes can be grouped in a transaction, they are
+ * written at once and reported with a single valuesChanged().
  */
 class Settings final : public QObject
 {
     Q_OBJECT
 
 public:
-    Settings(const QString organization, const QString name);
+    enum class Backend : qint8
+    {
+        Ini,
+        Binary
+    };
 
-    /* ============== system accessors ============= */
-    /*!
-     * \brief Returns information if system tray
-     * is available for current system.
-     */
-    bool trayAvailable() const;
-    /*!
-     * \brief Sets information if system tray
-     * is available for current system.
-     */
-    void setTrayAvailable(bool available);
+    using Changes = std::bitset<Setting::sc_count>; //! set of changed settings (by index)
 
     /*!
-     * \brief Returns information if system tray
-     * warning message should be displayed.
+     * \brief Returns true if any of settings S is in changes.
      */
-    bool showTrayInfo() const;
-    /*!
-     * \brief Sets information if system tray
-     * warning message should be displayed.
-     */
-    void setShowTrayInfo(bool show);
-    /* ============================================= */
+    template <typename... S>
+    static bool contains(const Changes &changes)
+    {
+        const bool found[] = { false, changes.test(Setting::IndexOf<S>::value)... };
+        for (bool f : found) {
+            if (f)
+                return true;
+        }
+        return false;
+    }
 
-    /* ============== logic accessors ============== */
-    /*!
-     * \brief Returns break duration in seconds.
-     */
-    int breakDuration() const;
-    /*!
-     * \brief Sets break duration in seconds.
-     */
-    void setBreakDuration(int duration);
+    Settings(const QString organization, const QString name, Backend backend = Backend::Ini);
+    ~Settings();
+
+    Backend backend() const;
 
     /*!
-     * \brief Returns break interval in seconds.
-     *
-     * Break interval is time between two breaks.
+     * \brief Returns value of setting S.
      */
-    int breakInterval() const;
+    template <typename S>
+    const typename S::Type &value() const
+    {
+        return std::get<Setting::IndexOf<S>::value>(m_values);
+    }
     /*!
-     * \brief Sets break interval in seconds.
-     *
-     * \see breakInterval()
+     * \brief Sets value of setting S.
+     * Emits valuesChanged() if the value is different,
+     * in a transaction change is reported on commit.
      */
-    void setBreakInterval(int interval);
+    template <typename S>
+    void setValue(const typename S::Type &value)
+    {
+        auto &slot = std::get<Setting::IndexOf<S>::value>(m_values);
+        if (slot == value)
+            return;
+
+        slot = value;
+        markDirty(Setting::IndexOf<S>::value);
+        if (!m_inTransaction)
+            emit valuesChanged(Changes().set(Setting::IndexOf<S>::value));
+    }
 
     /*!
-     * \brief Returns work day duratinon in seconds.
-     *
-     * Work day duration is total time of
-     * work time (time between breaks)
-     * for one day.
-     */
-    int workTime() const;
-    /*!
-     * \brief Sets work day duratinon in seconds.
-     *
-     * \see workTime()
+     * \brief Sets default values of all settings.
+     * Only changed settings are reported.
      */
-    void setWorkTime(int time);
+    void resetValues();
 
     /*!
-     * \brief Returns duration for postpone in seconds.
+     * \brief Starts grouping changes.
      */
-    int postponeTime() const;
+    void beginTransaction();
     /*!
-     * \brief Sets duration for postpone in seconds.
+     * \brief Writes all changes made since beginTransaction()
+     * and reports them with a single valuesChanged().
      */
-    void setPostponeTime(int time);
-
+    void commitTransaction();
     /*!
-     * \brief Returns information if application
-     * should start automatically after run.
+     * \brief Restores values from before beginTransaction().
      */
-    bool autoStart() const;
+    void rollbackTransaction();
+    bool isInTransaction() const;
+
     /*!
-     * \brief Sets information if application
-     * should start automatically after run.
+     * \brief Writes all pending changes to the settings file.
      */
-    void setAutoStart(bool start);
-
+    void flush();
     /*!
-     * \brief Returns information if application
-     * should be hidden automatically after run.
+     * \brief Returns number of disk writes saved by batching changes.
      */
-    bool autoHide() const;
+    int savedWrites() const;
     /*!
-     * \brief Sets information if application
-     * should be hidden automatically after run.
+     * \brief Reads settings file again if its content has changed.
+     *
+     * Settings with pending local changes are kept.
      */
-    void setAutoHide(bool hide);
+    void reload();
 
+signals:
     /*!
-     * \brief Returns information if application
-     * should be hidden instead quit on close action.
+     * \brief Informs about changed settings.
+     *
+     * \param changes   indexes of changed settings in the schema
      */
-    bool hideOnClose() const;
+    void valuesChanged(const Settings::Changes &changes) const;
+
+private:
+    using Values = Setting::Storage<>::Type;
+
+    QSettings m_settings;
+    Values m_values;    //! cached values
+    const Backend m_backend;
+    QString m_binaryFilePath;   //! used with binary backend
+
+    std::bitset<Setting::sc_count> m_dirty; //! settings waiting for flush
+    QTimer m_flushTimer;    //! restarted on each change
+    int m_writeCount = 0;   //! number of changes requested
+    int m_flushCount = 0;   //! number of actual disk writes
+
+    QFileSystemWatcher m_watcher;   //! watches settings file and its directory
+    QByteArray m_fileHash;  //! hash of settings file content known to the cache
+
+    bool m_inTransaction = false;
+    bool m_reloadPending = false;   //! file changed during transaction
+    Values m_transactionValues;     //! values from before transaction
+    Changes m_transactionDirty;     //! pending settings from before transaction
+
+    static const int sc_flushDelay; //! idle time before pending changes are written (in ms)
+
+    static const quint32 sc_binaryMagic;    //! binary file signature
+    static const quint16 sc_binaryVersion;  //! binary file format version
+
+    void markDirty(int index);
+
     /*!
-     * \brief Sets information if application
-     * should be hidden instead quit on close action.
+     * \brief Returns path of the file used by current backend.
      */
-    void setHideOnClose(bool hide);
-    /* ============================================= */
-
-    /* ============== update accessors ============== */
+    QString filePath() const;
     /*!
-     * \brief Returns previous update version check.
+     * \brief Returns hash of current settings file content.
      */
-    QString updateVersion() const;
+    QByteArray fileHash() const;
     /*!
-     * \brief Sets update version check.
+     * \brief Adds settings file to the watcher (again).
+     *
+     * Editors and QSettings itself replace the file on save,
+     * which removes it from the watcher.
      */
-    void setUpdateVersion(const QString &version);
+    void watchFile();
 
     /*!
-     * \brief Returns next update check date.
+     * \brief Sets default values of all settings of the list.
      */
-    QDateTime nextUpdateCheck() const;
+    template <typename... S>
+    void readDefaults(Values &values, std::tuple<S...> *) const;
+    template <typename... S>
+    void resetValues(std::tuple<S...> *);
     /*!
-     * \brief Sets next update check date.
+     * \brief Reads all settings of the list from QSettings.
      */
-    void setNextUpdateCheck(const QDateTime &checkDate);
-    /* ============================================= */
-
-    /* =============== view accessors ============== */
+    template <typename... S>
+    void readIni(Values &values, std::tuple<S...> *) const;
     /*!
-     * \brief Returns the lastest position of the main window.
+     * \brief Writes dirty settings of the list to QSettings.
      */
-    QPoint windowPosition() const;
+    template <typename... S>
+    void writeIni(std::tuple<S...> *);
     /*!
-     * \brief Sets a current positon of the main window.
+     * \brief Updates cached settings of the list which differ from given values.
+     *
+     * \return updated settings
      */
-    void setWindowPosition(const QPoint &position);
-
+    template <typename... S>
+    Changes update(const Values &values, std::tuple<S...> *);
+    template <typename S>
+    bool updateValue(const Values &values);
     /*!
-     * \brief Returns the lastest size of the main window.
+     * \brief Returns settings of the list which differ in given values.
      */
-    QSize windowSize() const;
+    template <typename... S>
+    static Changes differences(const Values &values1, const Values &values2, std::tuple<S...> *);
+
     /*!
-     * \brief Sets a current size of the main window.
+     * \brief Reads settings from memory mapped binary file.
+     *
+     * Settings missing in the file keep given values.
+     *
+     * \return false if file does not exist or is not valid
      */
-    void setWindowSize(const QSize &size);
-
+    bool readBinary(Values &values) const;
     /*!
-     * \brief Returns the application main color.
+     * \brief Atomically replaces binary file with all cached values.
      */
-    QColor applicationColor() const;
+    bool writeBinary();
     /*!
-     * \brief Sets the application main color.
+     * \brief Reads value of the setting with given record key from a binary record.
      */
-    void setApplicationColor(const QColor &color);
-    /* ============================================= */
+    template <typename... S>
+    void readRecord(const QByteArray &key, const QByteArray &data, Values &values, std::tuple<S...> *) const;
+    template <typename... S>
+    void writeRecords(QDataStream &stream, std::tuple<S...> *) const;
+    template <typename T>
+    static void readRecordValue(const QByteArray &data, T &value);
+    static void readRecordValue(const QByteArray &data, QList<BreakRule> &value);
+    template <typename T>
+    static QByteArray recordData(const T &value);
 
-    static void setDefaultApplicationColor(const QColor &value);
-
-private:
-    QSettings m_settings;
+    // storage format of value types
+    template <typename T>
+    T read(const QString &path, const T &defaultValue) const;
+    QPoint read(const QString &path, const QPoint &defaultValue) const;
+    QSize read(const QString &path, const QSize &defaultValue) const;
+    QColor read(const QString &path, const QColor &defaultValue) const;
+    QDateTime read(const QString &path, const QDateTime &defaultValue) const;
+    QList<BreakRule> read(const QString &path, const QList<BreakRule> &defaultValue) const;
 
-    static const QLatin1String sc_systemGroupName;  //! a name for the system settings group
-    static const QLatin1String sc_logicGroupName;   //! a name for the logic settings group
-    static const QLatin1String sc_updateGroupName;   //! a name for the logic settings group
-    static const QLatin1String sc_viewGroupName;    //! a name for the view settings group
-
-    // system keys
-    static const QLatin1String sc_trayAvailableKey;     //! key used for settings: tray available
-    static const QLatin1String sc_showTrayInfoKey;      //! key used for settings: show tray info
-    // logic keys
-    static const QLatin1String sc_breakDurationKey;     //! key used for settings: break duration
-    static const QLatin1String sc_breakIntervalKey;     //! key used for settings: break interval
-    static const QLatin1String sc_workTimeKey;   //! key used for settings: work day duration
-    static const QLatin1String sc_postponeTimeKey;      //! key used for settings: postpone time
-    static const QLatin1String sc_autoStartKey;         //! key used for settings: auto start
-    static const QLatin1String sc_autoHideKey;          //! key used for settings: auto hide
-    static const QLatin1String sc_hideOnCloseKey;       //! key used for settings: hide on close
-    // update keys
-    static const QLatin1String sc_updateVersionKey;     //! key used for settings: update version
-    static const QLatin1String sc_nextUpdateCheckKey;   //! key used for settings: next update check
-    // view keys
-    static const QLatin1String sc_windowPositionXKey;    //! key used for settings: window position x value
-    static const QLatin1String sc_windowPositionYKey;    //! key used for settings: window position y value
-    static const QLatin1String sc_windowWidthKey;  //! key used for settings: window width
-    static const QLatin1String sc_windowHeightKey; //! key used for settings: window height
-    static const QLatin1String sc_applicationColorKey; //! key used for settings: application main color
-
-    // logic default
-    static const int sc_defaultBreakDuration;   //! default braak duration \see breakDuration()
-    static const int sc_defaultBreakInterval;   //! default break interval \see breakInterval()
-    static const int sc_defaultWorkTime; //! default work day duration \see workTime()
-    static const int sc_defaultPostponeTime;    //! default postpone time \see postponeTime()
-    // view default
-    static const QSize sc_defaultWindowSize;    //! default postpone time \see postponeTime()
-    static QColor sc_defaultApplicationColor;    //! default postpone time \see postponeTime()
-
-    void setValue(const QString &groupName, const QString &key, const QVariant &value);
-    QVariant value(const QString &groupName, const QString &key, const QVariant &defaultValue = QVariant()) const;
+    template <typename T>
+    void write(const QString &path, const T &value);
+    void write(const QString &path, const QPoint &value);
+    void write(const QString &path, const QSize &value);
+    void write(const QString &path, const QColor &value);
+    void write(const QString &path, const QDateTime &value);
+    void write(const QString &path, const QList<BreakRule> &value);
 };
 
 #endif // SETTINGS_H
@@ -0,0 +1,227 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef SETTINGSSCHEMA_H
+#define SETTINGSSCHEMA_H
+
+#include <QString>
+#include <QPoint>
+#include <QSize>
+#include <QColor>
+#include <QDateTime>
+#include <QList>
+
+#include <tuple>
+#include <type_traits>
+
+#include "breakrule.h"
+
+/*!
+ * \brief Schema of application settings.
+ *
+ * Each setting is described by a type with its value type,
+ * key path ("group/key") and default value. Settings stores
+ * values in a tuple of typed slots generated from the schema,
+ * so accessing a setting is an index known at compile time.
+ *
+ * Key path is a prefix of INI keys and can be shared by settings
+ * stored as several keys (window position and size). Record key
+ * identifies the setting in the binary file and is unique.
+ */
+namespace Setting {
+
+// system settings
+struct TrayAvailable {
+    using Type = bool;
+    static constexpr const char *path() { return "system/trayAvailable"; }
+    static constexpr const char *key() { return "system/trayAvailable"; }
+    static Type defaultValue() { return false; }
+};
+struct ShowTrayInfo {
+    using Type = bool;
+    static constexpr const char *path() { return "system/showTrayInfo"; }
+    static constexpr const char *key() { return "system/showTrayInfo"; }
+    static Type defaultValue() { return true; }
+};
+
+// logic settings
+struct BreakDuration {
+    using Type = int;   //! in secs
+    static constexpr const char *path() { return "logic/breakDuration"; }
+    static constexpr const char *key() { return "logic/breakDuration"; }
+    static Type defaultValue() { return 10*60; }
+};
+struct BreakInterval {
+    using Type = int;   //! in secs
+    static constexpr const char *path() { return "logic/breakInterval"; }
+    static constexpr const char *key() { return "logic/breakInterval"; }
+    static Type defaultValue() { return 45*60; }
+};
+struct WorkTime {
+    using Type = int;   //! in secs
+    static constexpr const char *path() { return "logic/workTime"; }
+    static constexpr const char *key() { return "logic/workTime"; }
+    static Type defaultValue() { return 8*60*60; }
+};
+struct PostponeTime {
+    using Type = int;   //! in secs
+    static constexpr const char *path() { return "logic/postponeTime"; }
+    static constexpr const char *key() { return "logic/postponeTime"; }
+    static Type defaultValue() { return 5*60; }
+};
+struct AutoStart {
+    using Type = bool;
+    static constexpr const char *path() { return "logic/autoStart"; }
+    static constexpr const char *key() { return "logic/autoStart"; }
+    static Type defaultValue() { return false; }
+};
+struct AutoHide {
+    using Type = bool;
+    static constexpr const char *path() { return "logic/autoHide"; }
+    static constexpr const char *key() { return "logic/autoHide"; }
+    static Type defaultValue() { return false; }
+};
+struct HideOnClose {
+    using Type = bool;
+    static constexpr const char *path() { return "logic/hideOnClose"; }
+    static constexpr const char *key() { return "logic/hideOnClose"; }
+    static Type defaultValue() { return true; }
+};
+struct BreakRules {
+    using Type = QList<BreakRule>;  //! stored as an array
+    static constexpr const char *path() { return "logic/breakRules"; }
+    static constexpr const char *key() { return "logic/breakRules"; }
+    static Type defaultValue() { return {}; }
+};
+
+// update settings
+struct UpdateVersion {
+    using Type = QString;
+    static constexpr const char *path() { return "update/updateVersion"; }
+    static constexpr const char *key() { return "update/updateVersion"; }
+    static Type defaultValue() { return {}; }
+};
+struct NextUpdateCheck {
+    using Type = QDateTime; //! stored as ISO date
+    static constexpr const char *path() { return "update/nextUpdateCheck"; }
+    static constexpr const char *key() { return "update/nextUpdateCheck"; }
+    static Type defaultValue() { return {}; }
+};
+struct LastUpdateCheck {
+    using Type = QDateTime; //! stored as ISO date, time of the last successful check
+    static constexpr const char *path() { return "update/lastCheck"; }
+    static constexpr const char *key() { return "update/lastCheck"; }
+    static Type defaultValue() { return {}; }
+};
+struct UpdateSeed {
+    using Type = int;   //! random per installation, 0 if not generated yet
+    static constexpr const char *path() { return "update/seed"; }
+    static constexpr const char *key() { return "update/seed"; }
+    static Type defaultValue() { return 0; }
+};
+
+// view settings
+struct WindowPosition {
+    using Type = QPoint;    //! stored as "-x" and "-y" keys
+    static constexpr const char *path() { return "view/window"; }
+    static constexpr const char *key() { return "view/windowPosition"; }
+    static Type defaultValue() { return { -1, -1 }; }
+};
+struct WindowSize {
+    using Type = QSize;     //! stored as "-width" and "-height" keys
+    static constexpr const char *path() { return "view/window"; }
+    static constexpr const char *key() { return "view/windowSize"; }
+    static Type defaultValue() { return { 400, 200 }; }
+};
+struct ApplicationColor {
+    using Type = QColor;    //! invalid if not set
+    static constexpr const char *path() { return "view/mainColor"; }
+    static constexpr const char *key() { return "view/mainColor"; }
+    static Type defaultValue() { return {}; }
+};
+
+/*!
+ * \brief All settings, position in the list is the setting index.
+ */
+using Schema = std::tuple<
+    TrayAvailable, ShowTrayInfo,
+    BreakDuration, BreakInterval, WorkTime, PostponeTime,
+    AutoStart, AutoHide, HideOnClose, BreakRules,
+    UpdateVersion, NextUpdateCheck, LastUpdateCheck, UpdateSeed,
+    WindowPosition, WindowSize, ApplicationColor
+>;
+
+/*!
+ * \brief Index of setting S in the schema.
+ */
+template <typename S, typename List = Schema>
+struct IndexOf;
+template <typename S, typename... Rest>
+struct IndexOf<S, std::tuple<S, Rest...>> : std::integral_constant<int, 0> {};
+template <typename S, typename First, typename... Rest>
+struct IndexOf<S, std::tuple<First, Rest...>>
+        : std::integral_constant<int, 1 + IndexOf<S, std::tuple<Rest...>>::value> {};
+
+/*!
+ * \brief Tuple of value types of all settings in the list.
+ */
+template <typename List = Schema>
+struct Storage;
+template <typename... S>
+struct Storage<std::tuple<S...>> {
+    using Type = std::tuple<typename S::Type...>;
+};
+
+constexpr int sc_count = std::tuple_size<Schema>::value;
+
+constexpr bool equalKeys(const char *key1, const char *key2)
+{
+    return *key1 == *key2 && (*key1 == '\0' || equalKeys(key1 + 1, key2 + 1));
+}
+
+constexpr bool containsKey(const char *, std::tuple<> *)
+{
+    return false;
+}
+template <typename S, typename... Rest>
+constexpr bool containsKey(const char *key, std::tuple<S, Rest...> *)
+{
+    return equalKeys(key, S::key()) || containsKey(key, static_cast<std::tuple<Rest...>*>(nullptr));
+}
+
+/*!
+ * \brief Checks that record keys of all settings in the list are different.
+ */
+template <typename List = Schema>
+struct UniqueKeys;
+template <>
+struct UniqueKeys<std::tuple<>> : std::true_type {};
+template <typename S, typename... Rest>
+struct UniqueKeys<std::tuple<S, Rest...>>
+        : std::integral_constant<bool, !containsKey(S::key(), static_cast<std::tuple<Rest...>*>(nullptr))
+                                       && UniqueKeys<std::tuple<Rest...>>::value> {};
+
+static_assert(UniqueKeys<>::value, "record keys of settings must be unique");
+
+} // namespace Setting
+
+#endif // SETTINGSSCHEMA_H
@@ -0,0 +1,200 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "checkpointjournal.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QSaveFile>
+
+const quint32 CheckpointJournal::sc_magic = 0x52434B50; //! "RCKP"
+const int CheckpointJournal::sc_maxRecords = 1024;
+
+CheckpointJournal::CheckpointJournal(int payloadSize)
+    : m_payloadSize(payloadSize)
+{}
+
+CheckpointJournal::~CheckpointJournal()
+{
+    m_file.close();
+}
+
+QString CheckpointJournal::fileName() const
+{
+    return m_file.fileName();
+}
+
+void CheckpointJournal::setFileName(const QString &fileName)
+{
+    m_file.close();
+    m_file.setFileName(fileName);
+    m_sequence = 0;
+    m_recordCount = 0;
+    m_lastPayload.clear();
+}
+
+bool CheckpointJournal::exists() const
+{
+    return m_file.exists();
+}
+
+bool CheckpointJournal::readLast(QByteArray &payload)
+{
+    m_file.close();
+    scan();
+    if (m_lastPayload.isEmpty())
+        return false;
+
+    payload = m_lastPayload;
+    return true;
+}
+
+bool CheckpointJournal::append(const QByteArray &payload)
+{
+    Q_ASSERT(payload.size() == m_payloadSize);
+
+    if (m_recordCount >= sc_maxRecords)
+        compact();
+
+    if (!m_file.isOpen()) {
+        scan(); // continue after the last valid record
+        if (!m_file.open(QFile::WriteOnly | QFile::Append)) {
+            qWarning() << "[CheckpointJournal]" << "Cannot open journal:" << m_file.errorString();
+            return false;
+        }
+
+        // drop tail torn by a crash, so records stay aligned
+        const qint64 validSize = m_recordCount * static_cast<qint64>(recordSize());
+        if (m_file.size() != validSize)
+            m_file.resize(validSize);
+    }
+
+    const QByteArray data = record(m_sequence + 1, payload);
+    if (m_file.write(data) != data.size() || !m_file.flush()) {
+        qWarning() << "[CheckpointJournal]" << "Cannot write journal:" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    ++m_sequence;
+    ++m_recordCount;
+    m_lastPayload = payload;
+    return true;
+}
+
+bool CheckpointJournal::compact()
+{
+    m_file.close();
+    if (m_lastPayload.isEmpty()) {
+        m_file.remove();
+        m_recordCount = 0;
+        return true;
+    }
+
+    QSaveFile file(m_file.fileName());
+    if (!file.open(QFile::WriteOnly)) {
+        qWarning() << "[CheckpointJournal]" << "Cannot compact journal:" << file.errorString();
+        return false;
+    }
+
+    file.write(record(m_sequence, m_lastPayload));
+    if (!file.commit()) { // replaces previous file atomically
+        qWarning() << "[CheckpointJournal]" << "Cannot compact journal:" << file.errorString();
+        return false;
+    }
+
+    m_recordCount = 1;
+    return true;
+}
+
+void CheckpointJournal::remove()
+{
+    m_file.close();
+    m_file.remove();
+    m_recordCount = 0;
+    m_lastPayload.clear();
+}
+
+quint32 CheckpointJournal::sequence() const
+{
+    return m_sequence;
+}
+
+int CheckpointJournal::recordSize() const
+{
+    // magic, sequence, payload, checksum
+    return sizeof(quint32) + sizeof(quint32) + m_payloadSize + sizeof(quint16);
+}
+
+QByteArray CheckpointJournal::record(quint32 sequence, const QByteArray &payload) const
+{
+    QByteArray data;
+    data.reserve(recordSize());
+
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << sc_magic << sequence;
+    stream.writeRawData(payload.constData(), payload.size());
+    stream << qChecksum(data.constData(), data.size());
+    return data;
+}
+
+bool CheckpointJournal::parse(const char *data, quint32 &sequence, QByteArray &payload) const
+{
+    const int checksumOffset = recordSize() - sizeof(quint16);
+    QDataStream stream(QByteArray::fromRawData(data, recordSize()));
+
+    quint32 magic = 0;
+    quint16 checksum = 0;
+    stream >> magic >> sequence;
+    stream.skipRawData(m_payloadSize);
+    stream >> checksum;
+
+    if (magic != sc_magic || checksum != qChecksum(data, checksumOffset))
+        return false;
+
+    payload = QByteArray(data + 2*sizeof(quint32), m_payloadSize);
+    return true;
+}
+
+void CheckpointJournal::scan()
+{
+    m_sequence = 0;
+    m_recordCount = 0;
+    m_lastPayload.clear();
+
+    QFile file(m_file.fileName());
+    if (!file.open(QFile::ReadOnly))
+        return;
+
+    const QByteArray content = file.readAll();
+    const int size = recordSize();
+    for (int offset = 0; offset + size <= content.size(); offset += size) {
+        quint32 sequence = 0;
+        QByteArray payload;
+        if (!parse(content.constData() + offset, sequence, payload) || sequence <= m_sequence)
+            break; // torn or stale record ends valid part of the journal
+
+        m_sequence = sequence;
+        m_lastPayload = payload;
+        ++m_recordCount;
+    }
+}
@@ -0,0 +1,102 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef CHECKPOINTJOURNAL_H
+#define CHECKPOINTJOURNAL_H
+
+#include <QFile>
+#include <QByteArray>
+
+/*!
+ * \brief Append-only journal of fixed-size checkpoint records.
+ *
+ * Each record holds a sequence number, the payload and
+ * a checksum, so a record torn by a crash is detected and
+ * skipped. Writing a checkpoint appends one record to the file
+ * kept open, the file is rewritten (compacted to its last record)
+ * only once in a while.
+ */
+class CheckpointJournal final
+{
+public:
+    /*!
+     * \param payloadSize   size of each payload (in bytes)
+     */
+    explicit CheckpointJournal(int payloadSize);
+    ~CheckpointJournal();
+
+    QString fileName() const;
+    void setFileName(const QString &fileName);
+
+    bool exists() const;
+
+    /*!
+     * \brief Reads payload of the last valid record.
+     *
+     * \param payload   last payload
+     * \return false if journal contains no valid record
+     */
+    bool readLast(QByteArray &payload);
+    /*!
+     * \brief Appends a record with given payload.
+     * Journal is compacted first when it grew too large.
+     */
+    bool append(const QByteArray &payload);
+    /*!
+     * \brief Atomically rewrites journal with its last valid record only.
+     */
+    bool compact();
+    /*!
+     * \brief Removes journal file.
+     */
+    void remove();
+
+    /*!
+     * \brief Returns sequence number of the last record.
+     */
+    quint32 sequence() const;
+
+private:
+    static const quint32 sc_magic;      //! record signature
+    static const int sc_maxRecords;     //! records count triggering compaction
+
+    QFile m_file;           //! opened for appending
+    const int m_payloadSize;
+    quint32 m_sequence = 0; //! sequence number of the last record
+    int m_recordCount = 0;  //! records in the file
+    QByteArray m_lastPayload;   //! payload of the last valid record
+
+    int recordSize() const;
+    QByteArray record(quint32 sequence, const QByteArray &payload) const;
+    /*!
+     * \brief Checks record and reads its content.
+     *
+     * \return false if record is not valid
+     */
+    bool parse(const char *data, quint32 &sequence, QByteArray &payload) const;
+    /*!
+     * \brief Reads all records and finds the last valid one.
+     */
+    void scan();
+};
+
+#endif // CHECKPOINTJOURNAL_H
@@ -0,0 +1,152 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "clock.h"
+
+Clock::~Clock()
+{}
+
+QDateTime Clock::currentDateTime() const
+{
+    return QDateTime::fromMSecsSinceEpoch(wallTime());
+}
+
+Clock &Clock::system()
+{
+    static SystemClock systemClock;
+    return systemClock;
+}
+
+bool Clock::drivesTimers() const
+{
+    return false;
+}
+
+void Clock::timerStarted(ClockTimer &)
+{}
+
+void Clock::timerStopped(ClockTimer &)
+{}
+
+SystemClock::SystemClock()
+{
+    m_monotonicClock.start();
+}
+
+qint64 SystemClock::monotonicTime() const
+{
+    return m_monotonicClock.elapsed();
+}
+
+qint64 SystemClock::wallTime() const
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+ClockTimer::ClockTimer(Clock &clock, QObject *parent)
+    : QObject(parent), m_clock(clock)
+{
+    connect(&m_timer, &QTimer::timeout, this, &ClockTimer::onTimeout);
+}
+
+ClockTimer::~ClockTimer()
+{
+    stop();
+}
+
+int ClockTimer::interval() const
+{
+    return m_interval;
+}
+
+void ClockTimer::setInterval(int msecs)
+{
+    m_interval = msecs;
+    if (m_active)
+        start();
+}
+
+bool ClockTimer::isSingleShot() const
+{
+    return m_singleShot;
+}
+
+void ClockTimer::setSingleShot(bool singleShot)
+{
+    m_singleShot = singleShot;
+    m_timer.setSingleShot(singleShot);
+}
+
+void ClockTimer::setTimerType(Qt::TimerType type)
+{
+    m_timer.setTimerType(type);
+}
+
+bool ClockTimer::isActive() const
+{
+    return m_active;
+}
+
+qint64 ClockTimer::deadline() const
+{
+    return m_deadline;
+}
+
+void ClockTimer::start()
+{
+    m_active = true;
+    m_deadline = m_clock.monotonicTime() + m_interval;
+
+    if (m_clock.drivesTimers())
+        m_clock.timerStarted(*this);
+    else
+        m_timer.start(m_interval);
+}
+
+void ClockTimer::start(int msecs)
+{
+    m_interval = msecs;
+    start();
+}
+
+void ClockTimer::stop()
+{
+    if (!m_active)
+        return;
+
+    m_active = false;
+    if (m_clock.drivesTimers())
+        m_clock.timerStopped(*this);
+    else
+        m_timer.stop();
+}
+
+void ClockTimer::onTimeout()
+{
+    if (m_singleShot) {
+        stop();
+    } else {
+        m_deadline += qMax(m_interval, 1);
+    }
+
+    emit timeout();
+}
@@ -0,0 +1,141 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+class ClockTimer;
+
+/*!
+ * \brief Source of time for controllers and workers.
+ *
+ * System clock is used by default. Other implementations
+ * (e.g. VirtualClock) can be injected to control time flow.
+ */
+class Clock
+{
+public:
+    virtual ~Clock();
+
+    /*!
+     * \brief Returns monotonic time (in ms) counted from an unspecified point.
+     */
+    virtual qint64 monotonicTime() const = 0;
+    /*!
+     * \brief Returns wall clock time (in ms since epoch).
+     */
+    virtual qint64 wallTime() const = 0;
+
+    QDateTime currentDateTime() const;
+
+    /*!
+     * \brief Returns clock based on system time.
+     */
+    static Clock &system();
+
+protected:
+    friend class ClockTimer;
+
+    /*!
+     * \brief Returns true if clock triggers its timers by itself.
+     * Otherwise timers are triggered by the event loop.
+     */
+    virtual bool drivesTimers() const;
+    virtual void timerStarted(ClockTimer &timer);
+    virtual void timerStopped(ClockTimer &timer);
+};
+
+/*!
+ * \brief Clock using system monotonic and wall clocks.
+ */
+class SystemClock final : public Clock
+{
+public:
+    SystemClock();
+
+    qint64 monotonicTime() const override;
+    qint64 wallTime() const override;
+
+private:
+    QElapsedTimer m_monotonicClock;
+};
+
+/*!
+ * \brief Timer counting time of the given clock.
+ *
+ * Provides subset of QTimer interface.
+ */
+class ClockTimer final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ClockTimer(Clock &clock, QObject *parent = 0);
+    ~ClockTimer();
+
+    int interval() const;
+    /*!
+     * \brief Sets timer interval (in ms).
+     * Active timer is restarted with new interval.
+     */
+    void setInterval(int msecs);
+
+    bool isSingleShot() const;
+    void setSingleShot(bool singleShot);
+
+    void setTimerType(Qt::TimerType type);
+
+    bool isActive() const;
+    /*!
+     * \brief Returns monotonic time of next timeout (in ms).
+     * Meaningful only for active timer.
+     */
+    qint64 deadline() const;
+
+public slots:
+    void start();
+    void start(int msecs);
+    void stop();
+
+signals:
+    void timeout();
+
+private:
+    friend class VirtualClock;
+
+    Clock &m_clock;
+    QTimer m_timer; //! used when clock does not drive timers
+
+    int m_interval = 0;
+    bool m_singleShot = false;
+    bool m_active = false;
+    qint64 m_deadline = 0;
+
+private slots:
+    void onTimeout();
+};
+
+#endif // CLOCK_H
@@ -0,0 +1,201 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "livestatefile.h"
+
+#include <QDebug>
+#include <cstring>
+
+const quint32 LiveStateFile::sc_magic = 0x524C5354; //! "RLST"
+
+LiveStateFile::LiveStateFile(int payloadSize)
+    : m_payloadSize(payloadSize)
+{}
+
+LiveStateFile::~LiveStateFile()
+{
+    close();
+}
+
+QString LiveStateFile::fileName() const
+{
+    return m_file.fileName();
+}
+
+void LiveStateFile::setFileName(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+}
+
+bool LiveStateFile::exists() const
+{
+    return m_file.exists();
+}
+
+bool LiveStateFile::open()
+{
+    if (isOpen())
+        return true;
+
+    if (!m_file.open(QFile::ReadWrite)) {
+        qWarning() << "[LiveStateFile]" << "Cannot open file:" << m_file.errorString();
+        return false;
+    }
+
+    bool valid = (m_file.size() == fileSize());
+    if (!valid && !m_file.resize(fileSize())) {
+        qWarning() << "[LiveStateFile]" << "Cannot resize file:" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_map = m_file.map(0, fileSize());
+    if (!m_map) {
+        qWarning() << "[LiveStateFile]" << "Cannot map file:" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    quint32 header[2];
+    std::memcpy(header, m_map, sizeof(header));
+    if (!valid || header[0] != sc_magic || header[1] != quint32(m_payloadSize)) {
+        // start from scratch, existing content is not ours
+        std::memset(m_map, 0, fileSize());
+        header[0] = sc_magic;
+        header[1] = m_payloadSize;
+        std::memcpy(m_map, header, sizeof(header));
+    }
+
+    const int index = lastSlot();
+    m_sequence = 0;
+    if (index >= 0)
+        parse(index, m_sequence);
+    return true;
+}
+
+bool LiveStateFile::isOpen() const
+{
+    return (m_map != nullptr);
+}
+
+void LiveStateFile::close()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+    m_sequence = 0;
+}
+
+bool LiveStateFile::read(QByteArray &payload) const
+{
+    const int index = lastSlot();
+    if (index < 0)
+        return false;
+
+    payload = QByteArray(reinterpret_cast<const char *>(slot(index)) + sizeof(quint32), m_payloadSize);
+    return true;
+}
+
+bool LiveStateFile::write(const char *payload)
+{
+    if (!isOpen())
+        return false;
+
+    const quint32 sequence = m_sequence + 1;
+    uchar *data = slot(sequence % 2); // the other slot keeps previous state
+
+    std::memcpy(data, &sequence, sizeof(quint32));
+    std::memcpy(data + sizeof(quint32), payload, m_payloadSize);
+
+    const int checksumOffset = slotSize() - sizeof(quint32);
+    const quint32 checksum = qChecksum(reinterpret_cast<const char *>(data), checksumOffset);
+    std::memcpy(data + checksumOffset, &checksum, sizeof(quint32));
+
+    m_sequence = sequence;
+    return true;
+}
+
+void LiveStateFile::remove()
+{
+    close();
+    m_file.remove();
+}
+
+quint32 LiveStateFile::sequence() const
+{
+    return m_sequence;
+}
+
+int LiveStateFile::headerSize() const
+{
+    // magic, payload size
+    return 2*sizeof(quint32);
+}
+
+int LiveStateFile::slotSize() const
+{
+    // sequence, payload, checksum
+    return sizeof(quint32) + m_payloadSize + sizeof(quint32);
+}
+
+int LiveStateFile::fileSize() const
+{
+    return headerSize() + 2*slotSize();
+}
+
+uchar *LiveStateFile::slot(int index) const
+{
+    return m_map + headerSize() + index*slotSize();
+}
+
+bool LiveStateFile::parse(int index, quint32 &sequence) const
+{
+    const uchar *data = slot(index);
+    const int checksumOffset = slotSize() - sizeof(quint32);
+
+    quint32 checksum = 0;
+    std::memcpy(&sequence, data, sizeof(quint32));
+    std::memcpy(&checksum, data + checksumOffset, sizeof(quint32));
+
+    return (sequence != 0 &&
+            checksum == qChecksum(reinterpret_cast<const char *>(data), checksumOffset));
+}
+
+int LiveStateFile::lastSlot() const
+{
+    if (!isOpen())
+        return -1;
+
+    int last = -1;
+    quint32 lastSequence = 0;
+    for (int index = 0; index < 2; ++index) {
+        quint32 sequence = 0;
+        if (parse(index, sequence) && sequence > lastSequence) {
+            last = index;
+            lastSequence = sequence;
+        }
+    }
+    return last;
+}
@@ -0,0 +1,114 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef LIVESTATEFILE_H
+#define LIVESTATEFILE_H
+
+#include <QFile>
+#include <QByteArray>
+
+/*!
+ * \brief Small fixed-layout file mapped into memory,
+ * holding the most recent state.
+ *
+ * File contains two slots written alternately. Each slot holds
+ * a sequence number, the payload and a checksum, so a slot torn
+ * by a crash is detected and the other one is used. Writing
+ * a state is a plain memory copy, the kernel writes mapped
+ * pages back to the file on its own.
+ */
+class LiveStateFile final
+{
+public:
+    /*!
+     * \param payloadSize   size of the payload (in bytes)
+     */
+    explicit LiveStateFile(int payloadSize);
+    ~LiveStateFile();
+
+    QString fileName() const;
+    void setFileName(const QString &fileName);
+
+    bool exists() const;
+
+    /*!
+     * \brief Opens and maps the file, creating it if needed.
+     * Valid content of an existing file is preserved.
+     */
+    bool open();
+    bool isOpen() const;
+    /*!
+     * \brief Unmaps and closes the file.
+     */
+    void close();
+
+    /*!
+     * \brief Reads payload of the most recent valid slot.
+     * File has to be opened.
+     *
+     * \param payload   most recent payload
+     * \return false if file contains no valid slot
+     */
+    bool read(QByteArray &payload) const;
+    /*!
+     * \brief Writes payload to the older slot.
+     * Does nothing if file is not opened.
+     *
+     * \param payload   payloadSize bytes to write
+     */
+    bool write(const char *payload);
+    /*!
+     * \brief Closes and removes the file.
+     */
+    void remove();
+
+    /*!
+     * \brief Returns sequence number of the most recent slot.
+     */
+    quint32 sequence() const;
+
+private:
+    static const quint32 sc_magic;  //! file signature
+
+    QFile m_file;               //! kept opened while mapped
+    uchar *m_map = nullptr;     //! mapped file content
+    const int m_payloadSize;
+    quint32 m_sequence = 0;     //! sequence number of the most recent slot
+
+    int headerSize() const;
+    int slotSize() const;
+    int fileSize() const;
+    uchar *slot(int index) const;
+
+    /*!
+     * \brief Checks slot and reads its sequence number.
+     *
+     * \return false if slot is not valid
+     */
+    bool parse(int index, quint32 &sequence) const;
+    /*!
+     * \brief Returns index of the most recent valid slot or -1.
+     */
+    int lastSlot() const;
+};
+
+#endif // LIVESTATEFILE_H
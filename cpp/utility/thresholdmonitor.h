@@ -0,0 +1,83 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef THRESHOLDMONITOR_H
+#define THRESHOLDMONITOR_H
+
+#include <QMap>
+
+/*!
+ * \brief Detects crossings of thresholds by counter values.
+ *
+ * Threshold is crossed when its counter moves from a value
+ * below the target to a value reaching it
+ * (previous < target <= current), no matter how large
+ * the step is. Moving the target itself never crosses it.
+ */
+template <typename Key>
+class ThresholdMonitor final
+{
+public:
+    /*!
+     * \brief Sets target of the threshold.
+     */
+    void setTarget(Key key, qint64 target)
+    {
+        m_thresholds[key].target = target;
+    }
+
+    void remove(Key key)
+    {
+        m_thresholds.remove(key);
+    }
+
+    /*!
+     * \brief Updates counter value of the threshold.
+     *
+     * \return true if threshold has been crossed by this update
+     */
+    bool update(Key key, qint64 value)
+    {
+        auto &threshold = m_thresholds[key];
+        const bool crossed = (threshold.value < threshold.target && threshold.target <= value);
+        threshold.value = value;
+        return crossed;
+    }
+
+    /*!
+     * \brief Sets counter value of the threshold without checking crossing.
+     */
+    void reset(Key key, qint64 value)
+    {
+        m_thresholds[key].value = value;
+    }
+
+private:
+    struct Threshold {
+        qint64 target = 0;
+        qint64 value = 0;   //! lastly seen counter value
+    };
+
+    QMap<Key, Threshold> m_thresholds;
+};
+
+#endif // THRESHOLDMONITOR_H
@@ -0,0 +1,112 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "virtualclock.h"
+
+VirtualClock::VirtualClock(const QDateTime &startTime)
+    : m_wallOffset(startTime.toMSecsSinceEpoch())
+{}
+
+VirtualClock::~VirtualClock()
+{
+    Q_ASSERT_X(m_timers.isEmpty(), Q_FUNC_INFO, "Virtual clock destroyed before its timers.");
+}
+
+qint64 VirtualClock::monotonicTime() const
+{
+    return m_monotonicTime;
+}
+
+qint64 VirtualClock::wallTime() const
+{
+    return m_monotonicTime + m_wallOffset;
+}
+
+void VirtualClock::advance(qint64 msecs)
+{
+    const auto target = m_monotonicTime + msecs;
+    while (m_monotonicTime < target) {
+        advanceToNextTimer(target - m_monotonicTime);
+    }
+}
+
+qint64 VirtualClock::advanceToNextTimer(qint64 limit)
+{
+    const auto start = m_monotonicTime;
+    const auto target = start + qMax(limit, 0LL);
+
+    auto timer = nearestTimer();
+    if (!timer || timer->deadline() > target) {
+        m_monotonicTime = target;
+        return target - start;
+    }
+
+    const auto deadline = qMax(timer->deadline(), m_monotonicTime);
+    m_monotonicTime = deadline;
+
+    // trigger all timers having this deadline (they could change each other)
+    while ((timer = nearestTimer()) && timer->deadline() <= deadline) {
+        timer->onTimeout();
+    }
+
+    return m_monotonicTime - start;
+}
+
+void VirtualClock::sleep(qint64 msecs)
+{
+    m_wallOffset += msecs;
+}
+
+qint64 VirtualClock::nextTimerRemaining() const
+{
+    auto timer = nearestTimer();
+    if (!timer)
+        return -1;
+
+    return qMax(timer->deadline() - m_monotonicTime, 0LL);
+}
+
+bool VirtualClock::drivesTimers() const
+{
+    return true;
+}
+
+void VirtualClock::timerStarted(ClockTimer &timer)
+{
+    if (!m_timers.contains(&timer))
+        m_timers.append(&timer);
+}
+
+void VirtualClock::timerStopped(ClockTimer &timer)
+{
+    m_timers.removeOne(&timer);
+}
+
+ClockTimer *VirtualClock::nearestTimer() const
+{
+    ClockTimer *nearest = nullptr;
+    for (auto timer : m_timers) {
+        if (!nearest || timer->deadline() < nearest->deadline())
+            nearest = timer;
+    }
+    return nearest;
+}
@@ -0,0 +1,88 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef VIRTUALCLOCK_H
+#define VIRTUALCLOCK_H
+
+#include <QList>
+
+#include "clock.h"
+
+/*!
+ * \brief Clock which time passes only on request.
+ *
+ * Timers created with this clock are triggered synchronously
+ * while the time is advanced, in order of their deadlines.
+ * It allows to go through hours of simulated time instantly.
+ */
+class VirtualClock final : public Clock
+{
+public:
+    explicit VirtualClock(const QDateTime &startTime = QDateTime::currentDateTime());
+    ~VirtualClock();
+
+    qint64 monotonicTime() const override;
+    qint64 wallTime() const override;
+
+    /*!
+     * \brief Advances time triggering all timers on the way.
+     *
+     * \param msecs     time to advance (in ms)
+     */
+    void advance(qint64 msecs);
+    /*!
+     * \brief Advances time up to the nearest timer deadline
+     * and triggers timers having it.
+     *
+     * \param limit     maximal time to advance (in ms)
+     * \return time advanced (in ms)
+     */
+    qint64 advanceToNextTimer(qint64 limit);
+    /*!
+     * \brief Simulates system sleep.
+     * Only wall time is advanced and no timer is triggered.
+     *
+     * \param msecs     sleep duration (in ms)
+     */
+    void sleep(qint64 msecs);
+
+    /*!
+     * \brief Returns time left to the nearest timer deadline (in ms).
+     * Negative value if no timer is active.
+     */
+    qint64 nextTimerRemaining() const;
+
+protected:
+    bool drivesTimers() const override;
+    void timerStarted(ClockTimer &timer) override;
+    void timerStopped(ClockTimer &timer) override;
+
+private:
+    qint64 m_monotonicTime = 0;
+    qint64 m_wallOffset;    //! difference between wall and monotonic time
+
+    QList<ClockTimer*> m_timers;    //! active timers
+
+    ClockTimer *nearestTimer() const;
+};
+
+#endif // VIRTUALCLOCK_H
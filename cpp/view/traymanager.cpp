@@ -97,9 +97,7 @@ void TrayManager::initTrayIcon()
             this, &TrayManager::updateToolTip);
     connect(&m_controller.settings(), &SettingsController::workTimeChanged,
             this, &TrayManager::updateToolTip);
-    connect(&m_controller.timer(), &TimerController::elapsedWorkPeriodChanged,
-            this, &TrayManager::updateToolTip);
-    connect(&m_controller.timer(), &TimerController::elapsedWorkTimeChanged,
+    connect(&m_controller.timer(), &TimerController::snapshotChanged,
             this, &TrayManager::updateToolTip);
     updateToolTip();
 
@@ -21,24 +21,40 @@
 ********************************************/
 
 #include "backupmanager.h"
+#include "backupworker.h"
+#include "utility/checkpointjournal.h"
 
 #include <QDebug>
 #include <QCoreApplication>
 #include <QDir>
 #include <QDataStream>
 #include <QStandardPaths>
+#include <QThread>
 
 const QLatin1String BackupManager::sc_fileName = QLatin1String(".backup.dat"); // hidden file
+const QLatin1String BackupManager::sc_hotFileName = QLatin1String(".backup.hot.dat"); // hidden file
+const QLatin1String BackupManager::sc_liveStateFileName = QLatin1String(".backup.live"); // hidden file
 
 BackupManager::BackupManager(QObject *parent)
     : BackupManager(sc_defaultInterval, parent)
 {}
 BackupManager::BackupManager(int backupInterval, QObject *parent)
-    : QObject(parent), m_interval(backupInterval)
+    : BackupManager(Clock::system(), backupInterval, parent)
+{}
+BackupManager::BackupManager(Clock &clock, QObject *parent)
+    : BackupManager(clock, sc_defaultInterval, parent)
+{}
+BackupManager::BackupManager(Clock &clock, int backupInterval, QObject *parent)
+    : QObject(parent), m_clock(clock), m_timer(clock), m_interval(backupInterval),
+      m_hotWorker(startWorker()), m_durableWorker(startWorker()),
+      m_liveState(sc_liveStateSize)
 {}
 
 BackupManager::~BackupManager()
-{}
+{
+    finishWorker(m_hotWorker);
+    finishWorker(m_durableWorker);
+}
 
 int BackupManager::interval() const
 {
@@ -52,6 +68,8 @@ void BackupManager::setInterval(int backupInterval)
 
 void BackupManager::start()
 {
+    m_active = true;
+    m_liveState.open(); // reopen after cleanup
     doBackup();
     m_timer.start();
 }
@@ -63,8 +81,13 @@ void BackupManager::stop()
 
 void BackupManager::cleanup()
 {
-    // remove file
-    m_dataFile.remove();
+    // remove files
+    m_active = false;
+    m_lastData = Data();
+    m_liveGeneration = m_hotGeneration = m_durableGeneration = 0;
+    QMetaObject::invokeMethod(m_hotWorker, "remove", Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_durableWorker, "remove", Qt::QueuedConnection);
+    m_liveState.remove();
 }
 
 void BackupManager::forceBackup()
@@ -72,19 +95,118 @@ void BackupManager::forceBackup()
     doBackup();
 }
 
+bool BackupManager::saveTo(const QString &fileName)
+{
+    // stored in the saved record, strictly increasing even if the clock is not
+    m_saveTime = qMax(m_clock.wallTime(), m_lastSaveTime + 1);
+    m_lastSaveTime = m_saveTime;
+    doBackup();
+    m_saveTime = 0;
+
+    QMetaObject::invokeMethod(m_durableWorker, "save", Qt::QueuedConnection,
+                              Q_ARG(QString, fileName));
+    return m_durableWorker->wait(sc_waitTimeout);
+}
+
+bool BackupManager::readSaveTime(const QString &fileName, qint64 &saveTime)
+{
+    CheckpointJournal journal(sc_dataSize);
+    journal.setFileName(fileName);
+    QByteArray payload;
+    if (!journal.exists() || !journal.readLast(payload)) {
+        return false;
+    }
+
+    QDataStream dataStream(payload);
+    Data data;
+    quint32 generation = 0;
+    dataStream >> data >> generation >> saveTime;
+    return saveTime > 0;
+}
+
+void BackupManager::restoreSaved(const QString &fileName)
+{
+    QMetaObject::invokeMethod(m_durableWorker, "restoreSaved", Qt::QueuedConnection,
+                              Q_ARG(QString, fileName), Q_ARG(QString, backupPath()),
+                              Q_ARG(bool, false));
+}
+
+bool BackupManager::restoreFrom(const QString &fileName)
+{
+    QMetaObject::invokeMethod(m_durableWorker, "restoreSaved", Qt::QueuedConnection,
+                              Q_ARG(QString, fileName), Q_ARG(QString, backupPath()),
+                              Q_ARG(bool, true));
+    QMetaObject::invokeMethod(m_durableWorker, "restore", Qt::QueuedConnection,
+                              Q_ARG(QString, backupPath()));
+    if (!m_durableWorker->wait(sc_waitTimeout)) {
+        qWarning() << "Saved file not read in time:" << fileName;
+        return false;
+    }
+
+    Data readedData;
+    quint32 generation = 0;
+    if (!m_durableWorker->savedRestored() ||
+            !readNewer(m_durableWorker->restoredPayload(), readedData, generation)) {
+        return false;
+    }
+
+    // restored data starts a new generation, so it wins over all tiers
+    m_data = readedData;
+    emit backupData(readedData);
+    doBackup();
+    return true;
+}
+
+void BackupManager::checkpoint()
+{
+    if (!m_active) {
+        return;
+    }
+
+    emit aboutToBackup();
+    updateLiveState();
+    if (m_hotGeneration != m_generation) {
+        m_hotWorker->post(payload());
+        m_hotGeneration = m_generation;
+    }
+}
+
+void BackupManager::updateLiveState()
+{
+    if (m_data != m_lastData) { // new generation
+        ++m_generation;
+        m_lastData = m_data;
+    }
+
+    if ((m_liveGeneration != m_generation || m_liveData != m_lastLiveData) &&
+            m_liveState.write(livePayload().constData())) {
+        m_liveGeneration = m_generation;
+        m_lastLiveData = m_liveData;
+    }
+}
+
 QString BackupManager::backupPath() const
 {
     return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).absoluteFilePath(sc_fileName);
 }
 
+QString BackupManager::hotBackupPath() const
+{
+    return QDir(hotDirectory()).absoluteFilePath(sc_hotFileName);
+}
+
+QString BackupManager::liveStatePath() const
+{
+    return QDir(hotDirectory()).absoluteFilePath(sc_liveStateFileName);
+}
+
 void BackupManager::initialize()
 {
     // check if previous backup file exist and restore if so
-    setupFile();
     checkAndRestore();
 
     // initialize next backup checking
-    connect(&m_timer, &QTimer::timeout, this, &BackupManager::doBackup);
+    connect(&m_timer, &ClockTimer::timeout, this, &BackupManager::doDurableBackup);
     updateInterval();
 }
 
@@ -93,13 +215,106 @@ BackupManager::Data &BackupManager::data()
     return m_data;
 }
 
-void BackupManager::setupFile()
+BackupManager::LiveData &BackupManager::liveData()
+{
+    return m_liveData;
+}
+
+BackupWorker *BackupManager::startWorker()
+{
+    auto worker = new BackupWorker(sc_dataSize);
+    auto thread = new QThread;
+    worker->moveToThread(thread);
+    thread->start();
+    return worker;
+}
+
+void BackupManager::finishWorker(BackupWorker *worker)
+{
+    auto thread = worker->thread();
+    QMetaObject::invokeMethod(worker, "finish", Qt::QueuedConnection);
+    if (!thread->wait(sc_waitTimeout)) {
+        // never block quitting on a hung file system, worker is left behind
+        qWarning() << "Backup not finished in time";
+        return;
+    }
+
+    delete worker;
+    delete thread;
+}
+
+QString BackupManager::hotDirectory() const
+{
+    const auto runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtimeDir.isEmpty()) {
+        return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    }
+    // runtime directory is shared by all applications
+    return QDir(runtimeDir).absoluteFilePath(QCoreApplication::applicationName());
+}
+
+QByteArray BackupManager::payload() const
+{
+    QByteArray payload;
+    QDataStream dataStream(&payload, QIODevice::WriteOnly);
+    dataStream << m_lastData << quint32(m_generation) << qint64(m_saveTime);
+    return payload;
+}
+
+QByteArray BackupManager::livePayload() const
+{
+    QByteArray payload = this->payload();
+    QDataStream dataStream(&payload, QIODevice::WriteOnly | QIODevice::Append);
+    dataStream << m_liveData << qint64(m_clock.wallTime());
+    return payload;
+}
+
+bool BackupManager::readNewer(const QByteArray &payload, Data &data, quint32 &generation)
+{
+    if (payload.size() != sc_dataSize) {
+        return false;
+    }
+
+    QDataStream dataStream(payload);
+    Data readedData;
+    quint32 readedGeneration = 0;
+    dataStream >> readedData >> readedGeneration;
+    if (readedGeneration <= generation) {
+        return false;
+    }
+
+    data = readedData;
+    generation = readedGeneration;
+    return true;
+}
+
+bool BackupManager::readLive(const QByteArray &payload, Data &data, quint32 &generation) const
 {
-    auto backupPathDir = QFileInfo(backupPath()).absoluteDir();
-    if (!backupPathDir.exists())
-        backupPathDir.mkpath(backupPathDir.absolutePath());
+    if (payload.size() != sc_liveStateSize) {
+        return false;
+    }
+
+    QDataStream dataStream(payload);
+    Data readedData;
+    quint32 readedGeneration = 0;
+    qint64 saveTime = 0;
+    LiveData liveData;
+    qint64 writeTime = 0;
+    dataStream >> readedData >> readedGeneration >> saveTime >> liveData >> writeTime;
+    if (readedGeneration < generation) { // same generation, but with counting state
+        return false;
+    }
+
+    if (liveData.countingWork && liveData.segmentStart >= 0) {
+        const auto segmentEnd = qMin(m_clock.wallTime(), writeTime + sc_liveStateRefresh);
+        const auto segment = qMax<qint64>(segmentEnd - liveData.segmentStart, 0);
+        readedData.elapsedWorkPeriod = static_cast<int>((liveData.workPeriodBase + segment) / 1000);
+        readedData.elapsedWorkTime = static_cast<int>((liveData.workTimeBase + segment) / 1000);
+    }
 
-    m_dataFile.setFileName(backupPath());
+    data = readedData;
+    generation = readedGeneration;
+    return true;
 }
 
 void BackupManager::updateInterval()
@@ -109,44 +324,71 @@ void BackupManager::updateInterval()
 
 void BackupManager::checkAndRestore()
 {
-    /* if file not exist, it means that
-     * apllication has been closed normaly */
-    if (!m_dataFile.exists()) {
-        return;
-    }
+    m_liveState.setFileName(liveStatePath());
 
-    m_dataFile.open(QFile::ReadOnly);
-    if (!m_dataFile.isOpen()) {
-        qWarning() << "Cannot open previous backup file:"
-                   << m_dataFile.errorString();
-        return;
+    // tiers are read in parallel, restore is the only operation waited for at startup
+    QMetaObject::invokeMethod(m_hotWorker, "restore", Qt::QueuedConnection,
+                              Q_ARG(QString, hotBackupPath()));
+    QMetaObject::invokeMethod(m_durableWorker, "restore", Qt::QueuedConnection,
+                              Q_ARG(QString, backupPath()));
+    const bool hotRestored = m_hotWorker->wait(sc_waitTimeout);
+    const bool durableRestored = m_durableWorker->wait(sc_waitTimeout);
+    if (!hotRestored || !durableRestored) {
+        qWarning() << "Previous backup not read in time";
     }
 
-    QDataStream dataStream(&m_dataFile);
     Data readedData;
-    dataStream >> readedData;
+    quint32 generation = 0;
+
+    // saved state has to win over the hot tier
+    const bool savedRestored = (durableRestored && m_durableWorker->savedRestored());
+    if (durableRestored && readNewer(m_durableWorker->restoredPayload(), readedData, generation)) {
+        m_durableGeneration = generation;
+    }
+
+    if (!savedRestored && hotRestored &&
+            readNewer(m_hotWorker->restoredPayload(), readedData, generation)) {
+        m_hotGeneration = generation;
+    }
+    if (savedRestored) {
+        QMetaObject::invokeMethod(m_hotWorker, "remove", Qt::QueuedConnection);
+    }
+
+    const bool liveStateExists = m_liveState.exists();
+    QByteArray liveContent;
+    if (m_liveState.open() && liveStateExists && !savedRestored &&
+            m_liveState.read(liveContent) && readLive(liveContent, readedData, generation)) {
+        m_liveGeneration = generation;
+    }
+
+    m_data = m_lastData = readedData;
+    m_generation = generation;
+    updateLiveState(); // live state is not older than any tier again
 
     // jeśli poprawnie przeczytano dane
     if (!readedData.isEmpty()) {
         emit backupData(readedData);
     }
-
-    m_dataFile.close();
 }
 
 void BackupManager::doBackup()
 {
-    m_dataFile.open(QFile::WriteOnly | QFile::Truncate);
-    if (!m_dataFile.isOpen()) {
-        qWarning() << "Cannot open backup file:"
-                   << m_dataFile.errorString();
-        return;
-    }
+    emit aboutToBackup();
+    updateLiveState();
 
-    QDataStream dataStream(&m_dataFile);
-    dataStream << m_data;
+    const auto data = payload();
+    m_hotWorker->post(data);
+    m_durableWorker->post(data);
+    m_hotGeneration = m_durableGeneration = m_generation;
+}
 
-    m_dataFile.close();
+void BackupManager::doDurableBackup()
+{
+    checkpoint();
+    if (m_active && m_durableGeneration != m_generation) {
+        m_durableWorker->post(payload());
+        m_durableGeneration = m_generation;
+    }
 }
 
 bool BackupManager::Data::isEmpty()
@@ -155,14 +397,56 @@ bool BackupManager::Data::isEmpty()
             elapsedWorkTime == 0 );
 }
 
+bool BackupManager::Data::operator==(const Data &other) const
+{
+    return (elapsedWorkPeriod == other.elapsedWorkPeriod &&
+            elapsedWorkTime == other.elapsedWorkTime);
+}
+
+bool BackupManager::Data::operator!=(const Data &other) const
+{
+    return !(*this == other);
+}
+
+bool BackupManager::LiveData::operator==(const LiveData &other) const
+{
+    return (breakDurationBase == other.breakDurationBase &&
+            workPeriodBase == other.workPeriodBase &&
+            workTimeBase == other.workTimeBase &&
+            segmentStart == other.segmentStart &&
+            countingWork == other.countingWork);
+}
+
+bool BackupManager::LiveData::operator!=(const LiveData &other) const
+{
+    return !(*this == other);
+}
+
 QDataStream &operator<<(QDataStream &stream, const BackupManager::Data &data)
 {
-    stream << data.elapsedWorkPeriod << data.elapsedWorkTime;
+    stream << qint32(data.elapsedWorkPeriod) << qint32(data.elapsedWorkTime);
     return stream;
 }
 QDataStream &operator>>(QDataStream &stream, BackupManager::Data &data)
 {
-    stream >> data.elapsedWorkPeriod;
-    stream >> data.elapsedWorkTime;
+    qint32 elapsedWorkPeriod = 0, elapsedWorkTime = 0;
+    stream >> elapsedWorkPeriod >> elapsedWorkTime;
+    data.elapsedWorkPeriod = elapsedWorkPeriod;
+    data.elapsedWorkTime = elapsedWorkTime;
+    return stream;
+}
+
+QDataStream &operator<<(QDataStream &stream, const BackupManager::LiveData &liveData)
+{
+    stream << liveData.breakDurationBase << liveData.workPeriodBase << liveData.workTimeBase
+           << liveData.segmentStart << qint8(liveData.countingWork);
+    return stream;
+}
+QDataStream &operator>>(QDataStream &stream, BackupManager::LiveData &liveData)
+{
+    qint8 countingWork = 0;
+    stream >> liveData.breakDurationBase >> liveData.workPeriodBase >> liveData.workTimeBase
+           >> liveData.segmentStart >> countingWork;
+    liveData.countingWork = countingWork;
     return stream;
 }
@@ -24,13 +24,33 @@
 #define BACKUPMANAGER_H
 
 #include <QObject>
-#include <QTimer>
-#include <QFile>
+
+#include "utility/clock.h"
+#include "utility/livestatefile.h"
+
+class BackupWorker;
 
 /*!
  * \brief Class to handle backups.
  * It is used to save and restore current state
  * after any application or system breakdown.
+ *
+ * Backups are kept in two storage tiers:
+ *  - hot tier in the runtime directory (usually tmpfs), with a memory
+ *    mapped live state file updated on each timer refresh and
+ *    a checkpoint journal written on each state change,
+ *    the live state holds also the counting state, so elapsed
+ *    times are restored exactly without frequent refreshes,
+ *  - durable tier in the application data directory, with a checkpoint
+ *    journal written once per interval, on save and on forced backups.
+ *
+ * Each change of data starts a new generation, which is stored with
+ * the data in every copy. The copy with the highest generation
+ * is restored, unless a saved state has been restored.
+ *
+ * Journals are written by worker threads, one per tier, so a slow
+ * file system of one tier never delays the other one. Only the latest
+ * data is written if a worker is slow.
  */
 class BackupManager final : public QObject
 {
@@ -44,10 +64,31 @@ public:
         int elapsedWorkTime = 0;
 
         bool isEmpty();
+
+        bool operator==(const Data &other) const;
+        bool operator!=(const Data &other) const;
+    };
+
+    /*!
+     * \brief Counting state kept in the live state file along with data.
+     * Elapsed work times are computed from it on restore.
+     */
+    struct LiveData {
+        // times counted before the segment (in ms)
+        qint64 breakDurationBase = 0;
+        qint64 workPeriodBase = 0;
+        qint64 workTimeBase = 0;
+        qint64 segmentStart = -1;   //! wall time of counted segment start (ms since epoch), -1 if not counting
+        bool countingWork = true;
+
+        bool operator==(const LiveData &other) const;
+        bool operator!=(const LiveData &other) const;
     };
 
     explicit BackupManager(QObject *parent = 0);
     BackupManager(int interval, QObject *parent = 0);
+    explicit BackupManager(Clock &clock, QObject *parent = 0);
+    BackupManager(Clock &clock, int interval, QObject *parent = 0);
     ~BackupManager();
 
     int interval() const;
@@ -66,13 +107,63 @@ public:
      * \brief Doing a backup even if interval not yet passed.
      */
     void forceBackup();
+    /*!
+     * \brief Backups data and saves the durable journal as given file.
+     * Waits a limited time for the save to be done.
+     *
+     * The last record of the saved file holds the save time,
+     * which increases with each save.
+     *
+     * \return false if save is not done yet
+     */
+    bool saveTo(const QString &fileName);
+    /*!
+     * \brief Moves saved file to the durable journal, so it would be restored.
+     * Has to be called before initialize().
+     */
+    void restoreSaved(const QString &fileName);
+    /*!
+     * \brief Restores data from saved file, keeping the file.
+     * Emits backupData() with restored data.
+     *
+     * \return false if file could not be restored
+     */
+    bool restoreFrom(const QString &fileName);
+    /*!
+     * \brief Doing a hot tier backup if data changed since the last one.
+     * Called on state changes, ignored until backups are started.
+     */
+    void checkpoint();
+
+    /*!
+     * \brief Writes current data and counting state
+     * to the live state file if any of them changed.
+     * Cheap enough to be called on each timer refresh.
+     */
+    void updateLiveState();
+
+    /*!
+     * \brief Reads save time stored by saveTo() in given file.
+     *
+     * \param saveTime  wall time of the save (ms since epoch)
+     * \return false if file holds no valid saved record
+     */
+    static bool readSaveTime(const QString &fileName, qint64 &saveTime);
 
-    QString backupPath() const;
+    QString backupPath() const;     //! durable journal
+    QString hotBackupPath() const;  //! hot journal
+    QString liveStatePath() const;
 
     Data &data();
+    LiveData &liveData();
 
 signals:
     void backupData(const Data &data);
+    /*!
+     * \brief Emitted right before data is written,
+     * so it can be brought up to date.
+     */
+    void aboutToBackup();
 
 public slots:
     /*!
@@ -81,21 +172,77 @@ public slots:
     void initialize();
 
 private:
-    static const int sc_defaultInterval = 5*60;   // default interval (in secs)
+    static const int sc_defaultInterval = 5*60; // default interval (in secs)
+    static const int sc_dataSize = 3*sizeof(qint32) + sizeof(qint64); // size of serialized data with generation and save time (in bytes)
+    static const int sc_liveStateSize = sc_dataSize + 5*sizeof(qint64) + sizeof(qint8); // with counting state and write time
+    static const int sc_liveStateRefresh = 60*1000; // longest interval between live state writes while counting (in ms)
+    static const int sc_waitTimeout = 2000; // maximal wait for the worker (in ms)
     static const QLatin1String sc_fileName;
+    static const QLatin1String sc_hotFileName;
+    static const QLatin1String sc_liveStateFileName;
 
-    QTimer m_timer; //! used to trigger next backup
+    Clock &m_clock;
+    ClockTimer m_timer; //! used to trigger next durable backup
     int m_interval;  //! interval between each backup (in seconds)
+    bool m_active = false;  //! true if backups were started and not cleaned
+
+    BackupWorker *m_hotWorker;      //! writes hot journal in its own thread
+    BackupWorker *m_durableWorker;  //! writes durable journal in its own thread
+    LiveStateFile m_liveState;      //! mapped file with the most recent data
 
-    QFile m_dataFile;   //! file used to store and restore the data
     Data m_data;        //! currently storred data
+    Data m_lastData;    //! data of the current generation
+    LiveData m_liveData;        //! current counting state
+    LiveData m_lastLiveData;    //! counting state lastly written to the live state file
+    quint32 m_generation = 0;
+    qint64 m_saveTime = 0;      //! written with data during save, zero otherwise
+    qint64 m_lastSaveTime = 0;  //! of the last save done by this instance
+
+    // generations lastly written to each copy
+    quint32 m_liveGeneration = 0;
+    quint32 m_hotGeneration = 0;
+    quint32 m_durableGeneration = 0;
+
+    static BackupWorker *startWorker();
+    /*!
+     * \brief Lets worker finish pending operations and deletes it.
+     * Worker is left behind if it does not finish in time.
+     */
+    static void finishWorker(BackupWorker *worker);
+
+    /*!
+     * \brief Returns the runtime directory for the hot tier,
+     * data directory if there is no runtime directory.
+     */
+    QString hotDirectory() const;
 
-private slots:
     /*!
-     * \brief Setups file with backup data.
-     * Make it valid for open.
+     * \brief Returns current data with generation and save time serialized.
      */
-    void setupFile();
+    QByteArray payload() const;
+    /*!
+     * \brief Returns live state file content: payload(),
+     * counting state and current wall time.
+     */
+    QByteArray livePayload() const;
+    /*!
+     * \brief Reads data and generation if payload is newer than the current one.
+     *
+     * \return false if payload is empty or not newer
+     */
+    static bool readNewer(const QByteArray &payload, Data &data, quint32 &generation);
+    /*!
+     * \brief Reads live state if it is not older than the current one.
+     *
+     * Work times counted in the stored segment are added up to now,
+     * time after the last write up to one live state refresh interval,
+     * so a longer downtime is not counted as work.
+     *
+     * \return false if payload is empty or older
+     */
+    bool readLive(const QByteArray &payload, Data &data, quint32 &generation) const;
+
+private slots:
     /*!
      * \brief Reinitialize timer with current interval.
      */
@@ -103,13 +250,19 @@ private slots:
 
     /*!
      * \brief Cheks if previous backup exist and restore it.
-     * Has to be called after file setup and before first backup.
+     * Has to be called before first backup.
      */
     void checkAndRestore();
     void doBackup();
+    /*!
+     * \brief Doing a durable tier backup if data changed since the last one.
+     */
+    void doDurableBackup();
 };
 
 QDataStream &operator<<(QDataStream &stream, const BackupManager::Data &data);
 QDataStream &operator>>(QDataStream &stream, BackupManager::Data &data);
+QDataStream &operator<<(QDataStream &stream, const BackupManager::LiveData &liveData);
+QDataStream &operator>>(QDataStream &stream, BackupManager::LiveData &liveData);
 
 #endif // BACKUPMANAGER_H
@@ -0,0 +1,198 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "backupworker.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <QThread>
+
+#ifdef Q_OS_UNIX
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
+BackupWorker::BackupWorker(int payloadSize, QObject *parent)
+    : QObject(parent), m_journal(payloadSize), m_pending(nullptr)
+{}
+
+BackupWorker::~BackupWorker()
+{
+    delete m_pending.exchange(nullptr);
+}
+
+void BackupWorker::post(const QByteArray &payload)
+{
+    QByteArray *previous = m_pending.exchange(new QByteArray(payload));
+    if (previous) {
+        delete previous; // not written yet, write of the new one is already queued
+    } else {
+        QMetaObject::invokeMethod(this, "writePending", Qt::QueuedConnection);
+    }
+}
+
+bool BackupWorker::wait(int timeout)
+{
+    // releases of previous waits which timed out have lower numbers
+    const int sequence = ++m_waitSequence;
+    QMetaObject::invokeMethod(this, "releaseWaiting", Qt::QueuedConnection,
+                              Q_ARG(int, sequence));
+
+    QElapsedTimer timer;
+    timer.start();
+    QMutexLocker locker(&m_doneMutex);
+    while (m_doneSequence < sequence) {
+        const auto remaining = timeout - timer.elapsed();
+        if (remaining <= 0)
+            return false;
+        m_doneCondition.wait(&m_doneMutex, static_cast<unsigned long>(remaining));
+    }
+    return true;
+}
+
+QByteArray BackupWorker::restoredPayload() const
+{
+    return m_restoredPayload;
+}
+
+bool BackupWorker::savedRestored() const
+{
+    return m_savedRestored;
+}
+
+void BackupWorker::restoreSaved(const QString &savedFileName, const QString &fileName, bool keep)
+{
+    m_savedRestored = false;
+    if (!QFile::exists(savedFileName)) {
+        auto savePathDir = QFileInfo(savedFileName).absoluteDir();
+        if (!savePathDir.exists())
+            savePathDir.mkpath(savePathDir.absolutePath());
+        return;
+    }
+
+    m_journal.setFileName(fileName); // closed, before it is replaced
+    if (replaceFile(savedFileName, fileName, keep)) {
+        m_savedRestored = true;
+    } else {
+        qWarning() << "Cannot restore saved file.";
+    }
+}
+
+void BackupWorker::restore(const QString &fileName)
+{
+    auto backupPathDir = QFileInfo(fileName).absoluteDir();
+    if (!backupPathDir.exists())
+        backupPathDir.mkpath(backupPathDir.absolutePath());
+
+    m_journal.setFileName(fileName);
+    m_restoredPayload.clear();
+
+    /* if file not exist, it means that
+     * apllication has been closed normaly */
+    if (!m_journal.exists()) {
+        return;
+    }
+
+    if (!m_journal.readLast(m_restoredPayload)) {
+        qWarning() << "No valid record in previous backup file:"
+                   << m_journal.fileName();
+        return;
+    }
+    m_journal.compact(); // start next journal from the restored record
+}
+
+void BackupWorker::writePending()
+{
+    QScopedPointer<QByteArray> payload(m_pending.exchange(nullptr));
+    if (!payload) {
+        return;
+    }
+
+    if (!m_journal.append(*payload)) {
+        qWarning() << "Cannot write backup file:"
+                   << m_journal.fileName();
+    }
+}
+
+void BackupWorker::save(const QString &fileName)
+{
+    writePending();
+
+    auto savePathDir = QFileInfo(fileName).absoluteDir();
+    if (!savePathDir.exists())
+        savePathDir.mkpath(savePathDir.absolutePath());
+
+    if (!replaceFile(m_journal.fileName(), fileName, true)) {
+        qWarning() << "Cannot save backup file to:" << fileName;
+        return;
+    }
+    m_journal.compact(); // detach journal from the saved file
+}
+
+void BackupWorker::remove()
+{
+    delete m_pending.exchange(nullptr);
+    m_journal.remove();
+}
+
+void BackupWorker::finish()
+{
+    writePending();
+    thread()->quit();
+}
+
+bool BackupWorker::replaceFile(const QString &source, const QString &target, bool keep)
+{
+#ifdef Q_OS_UNIX
+    const QByteArray sourceName = QFile::encodeName(source);
+    const QByteArray targetName = QFile::encodeName(target);
+    if (!keep) {
+        return (::rename(sourceName.constData(), targetName.constData()) == 0);
+    }
+
+    // link to a temporary name first, rename replaces target atomically
+    const QString temp = target + QLatin1String(".tmp");
+    const QByteArray tempName = QFile::encodeName(temp);
+    ::unlink(tempName.constData());
+    if (::link(sourceName.constData(), tempName.constData()) != 0 &&
+            !QFile::copy(source, temp)) { // no hardlinks on this file system
+        return false;
+    }
+    return (::rename(tempName.constData(), targetName.constData()) == 0);
+#else
+    QFile::remove(target);
+    return keep ? QFile::copy(source, target)
+                : QFile::rename(source, target);
+#endif
+}
+
+void BackupWorker::releaseWaiting(int sequence)
+{
+    QMutexLocker locker(&m_doneMutex);
+    m_doneSequence = sequence;
+    m_doneCondition.wakeAll();
+}
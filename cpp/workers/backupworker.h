@@ -0,0 +1,139 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef BACKUPWORKER_H
+#define BACKUPWORKER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+
+#include "utility/checkpointjournal.h"
+
+/*!
+ * \brief Class doing backup file operations in its own thread.
+ *
+ * Payloads are passed with post() through a single slot mailbox.
+ * A payload not yet written when the next one arrives is dropped,
+ * so only the latest one is written. Other operations are invoked
+ * as queued slots and done in order of invocation.
+ *
+ * Public methods are called from the owner thread, slots
+ * are run in the worker thread.
+ */
+class BackupWorker final : public QObject
+{
+    Q_OBJECT
+public:
+    /*!
+     * \param payloadSize   size of each payload (in bytes)
+     */
+    explicit BackupWorker(int payloadSize, QObject *parent = 0);
+    ~BackupWorker();
+
+    /*!
+     * \brief Passes payload to be written to the journal.
+     * Lock-free, replaces previous payload if it was not written yet.
+     */
+    void post(const QByteArray &payload);
+    /*!
+     * \brief Waits until all operations invoked so far are done.
+     *
+     * \param timeout   maximal time to wait (in ms)
+     * \return false if operations are still in progress
+     */
+    bool wait(int timeout);
+
+    /*!
+     * \brief Returns payload read by restore(),
+     * empty if no valid backup existed.
+     * Valid once restore() is done.
+     */
+    QByteArray restoredPayload() const;
+    /*!
+     * \brief Returns true if the last restoreSaved() placed saved file
+     * as the journal. Valid once restoreSaved() is done.
+     */
+    bool savedRestored() const;
+
+public slots:
+    /*!
+     * \brief Places saved file as the journal, so it would be restored.
+     *
+     * \param keep    true if saved file has to be kept,
+     *                it is linked then instead of moved
+     */
+    void restoreSaved(const QString &savedFileName, const QString &fileName, bool keep);
+    /*!
+     * \brief Opens journal and reads the last record.
+     */
+    void restore(const QString &fileName);
+    /*!
+     * \brief Writes latest posted payload (if any).
+     */
+    void writePending();
+    /*!
+     * \brief Saves the journal as given file, after pending write.
+     * Journal file is linked instead of copied where possible,
+     * then it is compacted to a new file, so next records
+     * never reach the saved one.
+     */
+    void save(const QString &fileName);
+    /*!
+     * \brief Drops pending payload and removes journal file.
+     */
+    void remove();
+    /*!
+     * \brief Writes pending payload and stops the thread.
+     */
+    void finish();
+
+private:
+    CheckpointJournal m_journal;
+    std::atomic<QByteArray*> m_pending; //! latest payload not yet written
+    int m_waitSequence = 0;     //! number of the last wait, used in the owner thread
+    QMutex m_doneMutex;
+    QWaitCondition m_doneCondition; //! woken when a wait is released
+    int m_doneSequence = 0;     //! number of the last released wait, guarded by m_doneMutex
+
+    QByteArray m_restoredPayload;
+    bool m_savedRestored = false;
+
+    /*!
+     * \brief Atomically replaces target file with source file.
+     *
+     * \param keep    true if source file has to be kept,
+     *                it is hardlinked (or copied if not supported) then
+     */
+    static bool replaceFile(const QString &source, const QString &target, bool keep);
+
+private slots:
+    /*!
+     * \brief Releases the wait with given number
+     * and all earlier ones, operations invoked before are done.
+     */
+    void releaseWaiting(int sequence);
+};
+
+#endif // BACKUPWORKER_H
@@ -22,15 +22,18 @@
 
 #include "savemanager.h"
 
-#include <QFile>
-#include <QDir>
-#include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
+#include <QPair>
 #include <QStandardPaths>
 
+#include <algorithm>
+
 #include "workers/backupmanager.h"
 
 const QLatin1String SaveManager::sc_saveName = QLatin1String("saveData.dat");
+const QLatin1String SaveManager::sc_slotsDirName = QLatin1String("saves");
+const QLatin1String SaveManager::sc_slotSuffix = QLatin1String(".dat");
 
 SaveManager::SaveManager(BackupManager &manager, QObject *parent)
     : QObject(parent), m_backupManager(manager)
@@ -39,31 +42,79 @@ SaveManager::SaveManager(BackupManager &manager, QObject *parent)
 void SaveManager::initialize()
 {
     // this moves saved file to a backup file so it would be restored
-    if (QFile::exists(savePath()) ) {
-        auto backupPath = m_backupManager.backupPath();
+    m_backupManager.restoreSaved(savePath());
+}
 
-        if (QFile::exists(backupPath)) {
-            QFile::remove(backupPath);
-        }
+bool SaveManager::save()
+{
+    return m_backupManager.saveTo(savePath());
+}
 
-        QFile saveFile(savePath());
-        if (!saveFile.rename(backupPath)) {
-            qWarning() << "Cannot restore saved file.";
-        }
-    } else {
-        auto savePathDir = QFileInfo(savePath()).absoluteDir();
-        if (!savePathDir.exists())
-            savePathDir.mkpath(savePathDir.absolutePath());
+bool SaveManager::save(const QString &name)
+{
+    if (!isValidName(name)) {
+        qWarning() << "Invalid save slot name:" << name;
+        return false;
     }
+    return m_backupManager.saveTo(slotPath(name));
 }
 
-bool SaveManager::save()
+bool SaveManager::restore(const QString &name)
+{
+    if (!isValidName(name)) {
+        qWarning() << "Invalid save slot name:" << name;
+        return false;
+    }
+    return m_backupManager.restoreFrom(slotPath(name));
+}
+
+bool SaveManager::restoreLatest()
+{
+    const auto names = slotNames();
+    if (names.isEmpty()) {
+        return false;
+    }
+    return restore(names.first());
+}
+
+QStringList SaveManager::slotNames() const
 {
-    m_backupManager.forceBackup();
-    return QFile::copy(m_backupManager.backupPath(), savePath());
+    QList<QPair<qint64, QString>> savedSlots;  // save time and name
+    const auto slotFiles = QDir(slotsDirPath()).entryInfoList(QStringList() << (QString("*") + sc_slotSuffix),
+                                                              QDir::Files);
+    for (const auto &slotFile : slotFiles) {
+        qint64 saveTime = 0;
+        if (BackupManager::readSaveTime(slotFile.absoluteFilePath(), saveTime)) {
+            savedSlots << qMakePair(saveTime, slotFile.completeBaseName());
+        }
+    }
+    std::sort(savedSlots.begin(), savedSlots.end(),
+              [](const QPair<qint64, QString> &a, const QPair<qint64, QString> &b) { return a.first > b.first; });
+
+    QStringList names;
+    for (const auto &savedSlot : savedSlots) {
+        names << savedSlot.second;
+    }
+    return names;
 }
 
 QString SaveManager::savePath() const
 {
     return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).absoluteFilePath(sc_saveName);
 }
+
+QString SaveManager::slotPath(const QString &name) const
+{
+    return QDir(slotsDirPath()).absoluteFilePath(name + sc_slotSuffix);
+}
+
+QString SaveManager::slotsDirPath() const
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).absoluteFilePath(sc_slotsDirName);
+}
+
+bool SaveManager::isValidName(const QString &name)
+{
+    return (!name.isEmpty() && !name.startsWith('.') &&
+            QFileInfo(name).fileName() == name);
+}
@@ -24,11 +24,22 @@
 #define SAVEMANAGER_H
 
 #include <QObject>
+#include <QStringList>
 
 class BackupManager;
 
 /*!
  * \brief Class to save state.
+ *
+ * State is saved in snapshot slots. The default slot is used
+ * by Save && Quit and restored (consumed) on next start. Named
+ * slots are kept until overwritten and restored on demand,
+ * by name or the most recent one. Recency is given by the save
+ * time stored in the slot, not by the file modification time.
+ *
+ * A slot is the backup journal linked under the slot name,
+ * so saving and restoring copy no data where hardlinks
+ * are supported.
  */
 class SaveManager final : public QObject
 {
@@ -38,14 +49,38 @@ public:
     SaveManager(BackupManager &manager, QObject *parent = 0);
 
     void initialize();
-    bool save();
+    bool save();    //! save to the default slot
+    bool save(const QString &name);
 
-    QString savePath() const;
+    /*!
+     * \brief Restores named slot, the slot is kept.
+     */
+    bool restore(const QString &name);
+    /*!
+     * \brief Restores most recently saved named slot, the slot is kept.
+     */
+    bool restoreLatest();
+
+    /*!
+     * \brief Returns names of saved slots, most recent first.
+     */
+    QStringList slotNames() const;
+
+    QString savePath() const;   //! default slot
+    QString slotPath(const QString &name) const;
 
 private:
     static const QLatin1String sc_saveName;
+    static const QLatin1String sc_slotsDirName;
+    static const QLatin1String sc_slotSuffix;
 
     BackupManager &m_backupManager;
+
+    QString slotsDirPath() const;
+    /*!
+     * \brief Checks if name can be used as a file name.
+     */
+    static bool isValidName(const QString &name);
 };
 
 #endif // SAVEMANAGER_H
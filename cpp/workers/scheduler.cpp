@@ -0,0 +1,105 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "scheduler.h"
+
+#include <limits>
+
+Scheduler::Scheduler(QObject *parent)
+    : Scheduler(Clock::system(), parent)
+{}
+Scheduler::Scheduler(Clock &clock, QObject *parent)
+    : QObject(parent), m_clock(clock), m_timer(clock)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+
+    connect(&m_timer, &ClockTimer::timeout, this, &Scheduler::onTimeout);
+}
+
+void Scheduler::schedule(Scheduler::Event event, qint64 msecs)
+{
+    m_deadlines.insert(event, m_clock.monotonicTime() + qMax(msecs, 0LL));
+    rearm();
+}
+
+void Scheduler::cancel(Scheduler::Event event)
+{
+    if (m_deadlines.remove(event))
+        rearm();
+}
+
+void Scheduler::cancelAll()
+{
+    m_deadlines.clear();
+    m_timer.stop();
+}
+
+bool Scheduler::isScheduled(Scheduler::Event event) const
+{
+    return m_deadlines.contains(event);
+}
+
+qint64 Scheduler::remainingTime(Scheduler::Event event) const
+{
+    if (!m_deadlines.contains(event))
+        return -1;
+
+    return qMax(m_deadlines.value(event) - m_clock.monotonicTime(), 0LL);
+}
+
+void Scheduler::rearm()
+{
+    if (m_deadlines.isEmpty()) {
+        m_timer.stop();
+        return;
+    }
+
+    auto nearest = std::numeric_limits<qint64>::max();
+    for (auto deadline : m_deadlines)
+        nearest = qMin(nearest, deadline);
+
+    // timer interval is limited to int range
+    const auto interval = qBound(0LL, nearest - m_clock.monotonicTime(),
+                                 static_cast<qint64>(std::numeric_limits<int>::max()));
+    m_timer.start(static_cast<int>(interval));
+}
+
+void Scheduler::onTimeout()
+{
+    const auto now = m_clock.monotonicTime();
+
+    // collect reached events first, as handlers may schedule new ones
+    QMultiMap<qint64, Event> reached;
+    for (auto it = m_deadlines.begin(); it != m_deadlines.end(); ) {
+        if (it.value() <= now) {
+            reached.insert(it.value(), it.key());
+            it = m_deadlines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    rearm();
+
+    for (auto event : reached)
+        emit triggered(event);
+}
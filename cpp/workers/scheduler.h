@@ -0,0 +1,88 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <QObject>
+#include <QMap>
+
+#include "utility/clock.h"
+
+/*!
+ * \brief Class to trigger events at given deadlines.
+ *
+ * Only one single-shot timer is armed, for the nearest
+ * deadline, so there are no wakeups between events.
+ */
+class Scheduler final : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Event : qint8
+    {
+        BreakStart,
+        BreakEnd,
+        WorkEnd,
+        RuleBreakStart  //! nearest deadline of additional break rules
+    };
+
+    explicit Scheduler(QObject *parent = 0);
+    explicit Scheduler(Clock &clock, QObject *parent = 0);
+
+    /*!
+     * \brief Schedules an event to be triggered after given time.
+     * Replaces previous deadline of the event (if any).
+     *
+     * \param event     event to schedule
+     * \param msecs     time to the deadline (in ms)
+     */
+    void schedule(Event event, qint64 msecs);
+    void cancel(Event event);
+    void cancelAll();
+
+    bool isScheduled(Event event) const;
+    /*!
+     * \brief Returns time left to the event deadline (in ms).
+     * Negative value if event is not scheduled.
+     */
+    qint64 remainingTime(Event event) const;
+
+signals:
+    void triggered(Event event) const;
+
+private:
+    Clock &m_clock;         //! monotonic reference for deadlines
+    ClockTimer m_timer;     //! armed for the nearest deadline
+
+    QMap<Event, qint64> m_deadlines;    //! events deadlines (monotonic time in ms)
+
+    /*!
+     * \brief Arms timer for the nearest deadline.
+     */
+    void rearm();
+
+private slots:
+    void onTimeout();
+};
+
+#endif // SCHEDULER_H
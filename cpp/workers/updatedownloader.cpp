@@ -0,0 +1,305 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "updatedownloader.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+const QLatin1String UpdateDownloader::sc_directoryName = QLatin1String("updates");
+const QLatin1String UpdateDownloader::sc_partialSuffix = QLatin1String(".part");
+
+UpdateDownloader::UpdateDownloader(QObject *parent)
+    : UpdateDownloader(Clock::system(), parent)
+{}
+UpdateDownloader::UpdateDownloader(Clock &clock, QObject *parent)
+    : QObject(parent), m_clock(clock), m_tickTimer(clock), m_hash(QCryptographicHash::Sha256)
+{
+    m_tickTimer.setInterval(sc_tickInterval);
+    connect(&m_tickTimer, &ClockTimer::timeout, this, &UpdateDownloader::onTick);
+}
+
+UpdateDownloader::~UpdateDownloader()
+{
+    release();
+}
+
+int UpdateDownloader::rateLimit() const
+{
+    return m_rateLimit;
+}
+
+void UpdateDownloader::setRateLimit(int rateLimit)
+{
+    m_rateLimit = qMax(rateLimit, 0);
+}
+
+bool UpdateDownloader::isRunning() const
+{
+    return (m_reply || m_file.isOpen());
+}
+
+QString UpdateDownloader::filePath(const QUrl &url) const
+{
+    return QDir(directory()).absoluteFilePath(url.fileName());
+}
+
+void UpdateDownloader::start(const QUrl &url, const QByteArray &sha256)
+{
+    if (isRunning()) {
+        if (url == m_sourceUrl && sha256 == m_sha256)
+            return; // already in progress
+        cancel();
+    }
+
+    if (url.fileName().isEmpty() || sha256.isEmpty()) {
+        fail("Package url or hash is missing");
+        return;
+    }
+
+    m_sourceUrl = m_url = url;
+    m_sha256 = sha256.toLower();
+    m_redirectCounter = 0;
+
+    QDir().mkpath(directory());
+    if (QFile::exists(filePath(m_sourceUrl))) {
+        startVerification(filePath(m_sourceUrl), false);
+    } else {
+        request();
+    }
+}
+
+void UpdateDownloader::cancel()
+{
+    release();
+}
+
+QString UpdateDownloader::directory() const
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).absoluteFilePath(sc_directoryName);
+}
+
+QString UpdateDownloader::partialPath() const
+{
+    return filePath(m_sourceUrl) + sc_partialSuffix;
+}
+
+void UpdateDownloader::request()
+{
+    m_file.close();
+    m_file.setFileName(partialPath());
+    if (!m_file.open(QFile::WriteOnly | QFile::Append)) {
+        fail(m_file.errorString());
+        return;
+    }
+    m_received = m_file.size();
+    m_total = -1;
+    m_accepted = false;
+
+    if (!m_nam)
+        m_nam = new QNetworkAccessManager(this);
+
+    QNetworkRequest request(m_url);
+    if (m_received > 0) // resume
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(m_received) + "-");
+
+    m_reply = m_nam->get(request);
+    m_reply->setReadBufferSize(sc_readBufferSize);
+    connect(m_reply, &QNetworkReply::metaDataChanged, this, &UpdateDownloader::onMetaDataChanged);
+    connect(m_reply, &QNetworkReply::readyRead, this, &UpdateDownloader::onReadyRead);
+    connect(m_reply, &QNetworkReply::finished, this, &UpdateDownloader::onFinished);
+
+    m_tokens = 0;
+    m_lastRefill = m_clock.monotonicTime();
+    m_tickTimer.start();
+}
+
+void UpdateDownloader::drain()
+{
+    if (!m_reply || !m_accepted)
+        return;
+
+    auto size = m_reply->bytesAvailable();
+    if (m_rateLimit > 0)
+        size = qMin(size, m_tokens);
+    if (size <= 0)
+        return;
+
+    const auto data = m_reply->read(size);
+    if (m_file.write(data) != data.size()) {
+        fail(m_file.errorString());
+        return;
+    }
+    m_received += data.size();
+    if (m_rateLimit > 0)
+        m_tokens -= data.size();
+
+    emit progress(m_received, m_total);
+}
+
+void UpdateDownloader::refill()
+{
+    const auto now = m_clock.monotonicTime();
+    const qint64 burst = qMax<qint64>(m_rateLimit / 2, sc_readBufferSize); // half a second of data
+    m_tokens = qMin(burst, m_tokens + (now - m_lastRefill) * m_rateLimit / 1000);
+    m_lastRefill = now;
+}
+
+void UpdateDownloader::complete()
+{
+    release();
+    startVerification(partialPath(), true);
+}
+
+void UpdateDownloader::startVerification(const QString &fileName, bool partial)
+{
+    m_file.close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QFile::ReadOnly)) {
+        fail(m_file.errorString());
+        return;
+    }
+
+    m_verifyingPartial = partial;
+    m_hash.reset();
+    QMetaObject::invokeMethod(this, "verifyChunk", Qt::QueuedConnection);
+}
+
+void UpdateDownloader::release()
+{
+    m_tickTimer.stop();
+    if (m_reply) {
+        m_reply->disconnect(this);
+        m_reply->abort();
+        m_reply->deleteLater();
+        m_reply = nullptr;
+    }
+    if (m_nam) { // not needed until next download
+        m_nam->deleteLater();
+        m_nam = nullptr;
+    }
+    m_file.close();
+}
+
+void UpdateDownloader::fail(const QString &errorString)
+{
+    qWarning() << "[UpdateDownloader]" << "Download failed:" << errorString;
+    release();
+    emit error(errorString);
+}
+
+void UpdateDownloader::onMetaDataChanged()
+{
+    const auto httpStatusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (httpStatusCode == 206) {
+        static const QRegularExpression totalRegExp("/(\\d+)$");
+        auto totalMatch = totalRegExp.match(QString::fromLatin1(m_reply->rawHeader("Content-Range")));
+        if (totalMatch.hasMatch())
+            m_total = totalMatch.captured(1).toLongLong();
+        m_accepted = true;
+    } else if (httpStatusCode == 200) {
+        if (m_received > 0) { // range ignored, start from the beginning
+            m_file.resize(0);
+            m_received = 0;
+        }
+        m_total = m_reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        if (m_total <= 0)
+            m_total = -1;
+        m_accepted = true;
+    }
+}
+
+void UpdateDownloader::onReadyRead()
+{
+    drain();
+}
+
+void UpdateDownloader::onFinished()
+{
+    const auto httpStatusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const auto isRedirect = (httpStatusCode == 301 || httpStatusCode == 302 || httpStatusCode == 303
+                             || httpStatusCode == 307 || httpStatusCode == 308);
+
+    if (isRedirect && m_redirectCounter++ < sc_maxRedirects) {
+        m_url = m_url.resolved(m_reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl());
+        m_reply->deleteLater();
+        m_reply = nullptr;
+        request();
+    } else if (httpStatusCode == 416) { // nothing left to download
+        complete();
+    } else if (m_reply->error() != QNetworkReply::NoError || !m_accepted) {
+        fail(QString("%1 %2").arg(httpStatusCode).arg(m_reply->errorString()));
+    } else if (m_reply->bytesAvailable() == 0) {
+        complete();
+    } // otherwise rest of the data is written on next ticks
+}
+
+void UpdateDownloader::onTick()
+{
+    refill();
+    drain();
+
+    if (m_reply && m_reply->isFinished() && m_reply->bytesAvailable() == 0
+            && m_reply->error() == QNetworkReply::NoError && m_accepted) {
+        complete();
+    }
+}
+
+void UpdateDownloader::verifyChunk()
+{
+    if (!m_file.isOpen() || m_file.openMode() != QFile::ReadOnly)
+        return; // cancelled
+
+    m_hash.addData(m_file.read(sc_hashChunkSize));
+    if (!m_file.atEnd()) {
+        QMetaObject::invokeMethod(this, "verifyChunk", Qt::QueuedConnection);
+        return;
+    }
+    m_file.close();
+
+    const auto fileName = m_file.fileName();
+    if (m_hash.result().toHex() != m_sha256) {
+        QFile::remove(fileName);
+        if (m_verifyingPartial) {
+            fail("Package hash does not match");
+        } else {
+            request(); // stale package, download it again
+        }
+        return;
+    }
+
+    const auto packagePath = filePath(m_sourceUrl);
+    if (m_verifyingPartial) {
+        QFile::remove(packagePath);
+        if (!QFile::rename(fileName, packagePath)) {
+            fail("Cannot move downloaded package");
+            return;
+        }
+    }
+    emit finished(packagePath);
+}
@@ -0,0 +1,152 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef UPDATEDOWNLOADER_H
+#define UPDATEDOWNLOADER_H
+
+#include <QObject>
+#include <QUrl>
+#include <QFile>
+#include <QCryptographicHash>
+
+#include "utility/clock.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/*!
+ * \brief Class downloading update package in the background.
+ *
+ * Package is downloaded to a partial file in the cache directory.
+ * Interrupted download is resumed with an HTTP Range request.
+ * Download rate is limited with a token bucket: data is read from
+ * the reply only as fast as tokens are refilled, and the small read
+ * buffer of the reply slows down the transfer itself.
+ *
+ * Downloaded file is verified against its SHA-256 hash, chunk by chunk
+ * through the event loop, so nothing blocks the GUI.
+ */
+class UpdateDownloader final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UpdateDownloader(QObject *parent = 0);
+    explicit UpdateDownloader(Clock &clock, QObject *parent = 0);
+    ~UpdateDownloader();
+
+    /*!
+     * \brief Returns download rate limit (in bytes per second),
+     * 0 if rate is not limited.
+     */
+    int rateLimit() const;
+    void setRateLimit(int rateLimit);
+
+    bool isRunning() const;
+
+    /*!
+     * \brief Returns path of the downloaded package.
+     */
+    QString filePath(const QUrl &url) const;
+
+public slots:
+    /*!
+     * \brief Starts or resumes download of the package.
+     * Already downloaded package is only verified.
+     *
+     * \param url       package url
+     * \param sha256    expected SHA-256 hash of the package (hex)
+     */
+    void start(const QUrl &url, const QByteArray &sha256);
+    /*!
+     * \brief Stops download, partial file is kept for resume.
+     */
+    void cancel();
+
+signals:
+    /*!
+     * \param received  bytes downloaded so far
+     * \param total     package size, -1 if unknown
+     */
+    void progress(qint64 received, qint64 total) const;
+    void finished(const QString &filePath) const;
+    void error(const QString &errorString) const;
+
+private:
+    static const int sc_tickInterval = 100;         // ms, refill of the token bucket
+    static const int sc_readBufferSize = 64*1024;   // bytes
+    static const int sc_hashChunkSize = 1024*1024;  // bytes, hashed at once
+    static const int sc_maxRedirects = 5;
+    static const QLatin1String sc_directoryName;
+    static const QLatin1String sc_partialSuffix;
+
+    Clock &m_clock;
+    ClockTimer m_tickTimer;     //! runs during download only
+
+    QNetworkAccessManager *m_nam = nullptr;   //! exists during download only
+    QNetworkReply *m_reply = nullptr;
+    int m_redirectCounter = 0;
+    bool m_accepted = false;    //! true if reply body is the package data
+
+    QUrl m_sourceUrl;   //! requested url, names the package
+    QUrl m_url;         //! current url, after redirects
+    QByteArray m_sha256;
+
+    QFile m_file;
+    qint64 m_received = 0;
+    qint64 m_total = -1;
+
+    int m_rateLimit = 0;
+    qint64 m_tokens = 0;        //! bytes allowed to read now
+    qint64 m_lastRefill = 0;    //! monotonic time of last refill
+
+    QCryptographicHash m_hash;
+    bool m_verifyingPartial = false;    //! false if downloaded package is verified
+
+    QString directory() const;
+    QString partialPath() const;
+
+    void request();
+    /*!
+     * \brief Writes available data, as much as tokens allow.
+     */
+    void drain();
+    void refill();
+    /*!
+     * \brief Ends transfer and starts verification of partial file.
+     */
+    void complete();
+    void startVerification(const QString &fileName, bool partial);
+    /*!
+     * \brief Stops transfer and releases network resources.
+     */
+    void release();
+    void fail(const QString &errorString);
+
+private slots:
+    void onMetaDataChanged();
+    void onReadyRead();
+    void onFinished();
+    void onTick();
+    void verifyChunk();
+};
+
+#endif // UPDATEDOWNLOADER_H
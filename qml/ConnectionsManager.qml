@@ -42,9 +42,7 @@ QtObject {
 
     // update controller
     property var updateConnections: Connections {
-        property bool initialCheck: true
-
-        function onInitialCheckFinished() {
+        function onScheduledCheckFinished() {
             if (controller.updater.updateAvailable) {
                 var showUpdateDialog = false;
                 if (controller.updater.compareVersions(controller.updater.newestVersion,
@@ -65,9 +63,8 @@ QtObject {
         target: controller.updater
 
         onCheckFinished: {
-            if (initialCheck) {
-                initialCheck = false;
-                onInitialCheckFinished();
+            if (scheduled) {
+                onScheduledCheckFinished();
             } else {
                 if (controller.updater.updateAvailable) {
                     dialogsManager.showUpdateInfoDialog();
@@ -77,12 +74,13 @@ QtObject {
             }
         }
         onCheckError: {
-            if (initialCheck) {
-                initialCheck = false;
-            } else {
+            if (!scheduled) {
                 dialogsManager.showUpdateErrorDialog();
             }
         }
+        onDownloadStarted: {
+            dialogsManager.showUpdateDownloadDialog();
+        }
     }
 }
 
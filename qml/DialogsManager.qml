@@ -51,6 +51,9 @@ Item {
     function showUpdateErrorDialog() {
         d.showDialog(updateErrorDialog)
     }
+    function showUpdateDownloadDialog() {
+        d.showDialog(updateDownloadDialog)
+    }
     function showChangeTimeDialog() {
         d.showDialog(changeTimeDialog)
     }
@@ -176,6 +179,15 @@ Item {
             description: qsTr("Please check your internet connection and try again.")
         }
     }
+    Component {
+        id: updateDownloadDialog
+
+        UpdateDownloadDialog {
+            onCancel: {
+                controller.updater.cancelDownload();
+            }
+        }
+    }
     Component {
         id: changeTimeDialog
 
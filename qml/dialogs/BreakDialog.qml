@@ -25,6 +25,7 @@ import QtQuick.Layouts 1.1
 import QtQuick.Controls 1.4
 import QtQml.Models 2.2
 import "../components"
+import ".."
 
 CustomDialog {
     signal endBreak();
@@ -63,10 +64,14 @@ CustomDialog {
     additionalContent.fillWidth: true
     additionalContent.data: TimeProgressBar {
         width: parent.width
-        maxValue: controller.settings.breakDuration
+        maxValue: controller.breakDuration
         value: controller.timer.elapsedBreakDuration
     }
 
+    TimerObserver {
+        active: visible
+    }
+
     Connections {
         target: controller
 
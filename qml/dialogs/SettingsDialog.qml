@@ -33,10 +33,13 @@ CustomDialog {
     image.source: "qrc:/resources/images/settings.png"
 
     function save() {
+        // all pages are applied at once
+        controller.settings.beginTransaction();
         for (var i=0; i<tabView.count; ++i) {
             tabView.getTab(i).active = true;
             tabView.getTab(i).item.save();
         }
+        controller.settings.commitTransaction();
     }
     function discard() {
         for (var i=0; i<tabView.count; ++i) {
@@ -0,0 +1,75 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+import QtQuick 2.5
+import QtQuick.Controls 1.4
+import QtQuick.Layouts 1.1
+import QtQml.Models 2.2
+import "../components"
+
+CustomDialog {
+    signal cancel()
+
+    property bool downloading: true
+
+    title: qsTr("Downloading update")
+    description: qsTr("Connecting...")
+
+    buttons: ObjectModel {
+        TextButton {
+            text: downloading ? qsTr("Cancel") : qsTr("Ok")
+
+            onClicked: {
+                close();
+                if (downloading) {
+                    cancel();
+                }
+            }
+        }
+    }
+
+    QtObject {
+        id: d
+
+        function formatSize(bytes) {
+            return (bytes / (1024*1024)).toFixed(1) + " MB";
+        }
+    }
+
+    Connections {
+        target: controller.updater
+
+        onDownloadProgress: {
+            description = qsTr("Downloaded") + " " + d.formatSize(received) +
+                    (total > 0 ? (" " + qsTr("of") + " " + d.formatSize(total)) : "");
+        }
+        onDownloadFinished: {
+            downloading = false;
+            description = qsTr("The package is verified and opened.");
+        }
+        onDownloadError: {
+            downloading = false;
+            description = qsTr("Download failed:") + " " + errorString + "\n" +
+                    qsTr("The package is opened in the browser.");
+        }
+    }
+}
@@ -52,8 +52,8 @@ Window {
         y = controller.settings.windowPosition.y >= 0 ?
                     controller.settings.windowPosition.y : (Screen.height - height)/2
 
-        // check if update available
-        controller.updater.checkUpdateAvailable();
+        // check if update available, spread over time between installations
+        controller.updater.scheduleUpdateCheck();
     }
 
     onWidthChanged: {
@@ -83,6 +83,9 @@ Window {
     ConnectionsManager {
         dialogsManager: dialogsManager
     }
+    TimerObserver {
+        active: visibility !== Window.Hidden && visibility !== Window.Minimized
+    }
 
     // content
     ColumnLayout {
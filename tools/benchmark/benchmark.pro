@@ -0,0 +1,70 @@
+TEMPLATE = app
+TARGET = resto-benchmark
+
+QT += core gui network qml quick widgets
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+ROOT_DIR = $$PWD/../..
+INCLUDEPATH += $$ROOT_DIR/cpp/ \
+    $$PWD/../common/
+
+SOURCES += main.cpp \
+    fanout.cpp \
+    legacyupdateclient.cpp \
+    settingsreads.cpp \
+    startup.cpp \
+    updateload.cpp \
+    $$PWD/../common/httpstandin.cpp \
+    $$PWD/../common/isolatedstorage.cpp \
+    $$ROOT_DIR/cpp/controller/controller.cpp \
+    $$ROOT_DIR/cpp/model/settings.cpp \
+    $$ROOT_DIR/cpp/model/breakschedule.cpp \
+    $$ROOT_DIR/cpp/controller/settingscontroller.cpp \
+    $$ROOT_DIR/cpp/controller/timercontroller.cpp \
+    $$ROOT_DIR/cpp/workers/backupmanager.cpp \
+    $$ROOT_DIR/cpp/view/traymanager.cpp \
+    $$ROOT_DIR/cpp/workers/savemanager.cpp \
+    $$ROOT_DIR/cpp/utility/helpers.cpp \
+    $$ROOT_DIR/cpp/controller/updatecontroller.cpp \
+    $$ROOT_DIR/cpp/workers/scheduler.cpp \
+    $$ROOT_DIR/cpp/workers/backupworker.cpp \
+    $$ROOT_DIR/cpp/workers/updatedownloader.cpp \
+    $$ROOT_DIR/cpp/utility/clock.cpp \
+    $$ROOT_DIR/cpp/utility/checkpointjournal.cpp \
+    $$ROOT_DIR/cpp/utility/livestatefile.cpp \
+    $$ROOT_DIR/cpp/utility/virtualclock.cpp
+
+RESOURCES += $$ROOT_DIR/qml.qrc
+
+HEADERS += \
+    fanout.h \
+    legacyupdateclient.h \
+    settingsreads.h \
+    startup.h \
+    updateload.h \
+    $$PWD/../common/httpstandin.h \
+    $$PWD/../common/isolatedstorage.h \
+    $$ROOT_DIR/cpp/controller/controller.h \
+    $$ROOT_DIR/cpp/model/settings.h \
+    $$ROOT_DIR/cpp/model/settingsschema.h \
+    $$ROOT_DIR/cpp/model/breakrule.h \
+    $$ROOT_DIR/cpp/model/breakschedule.h \
+    $$ROOT_DIR/cpp/controller/settingscontroller.h \
+    $$ROOT_DIR/cpp/controller/timercontroller.h \
+    $$ROOT_DIR/cpp/workers/backupmanager.h \
+    $$ROOT_DIR/cpp/view/traymanager.h \
+    $$ROOT_DIR/cpp/workers/savemanager.h \
+    $$ROOT_DIR/cpp/utility/helpers.h \
+    $$ROOT_DIR/cpp/controller/updatecontroller.h \
+    $$ROOT_DIR/cpp/workers/scheduler.h \
+    $$ROOT_DIR/cpp/workers/backupworker.h \
+    $$ROOT_DIR/cpp/workers/updatedownloader.h \
+    $$ROOT_DIR/cpp/utility/clock.h \
+    $$ROOT_DIR/cpp/utility/checkpointjournal.h \
+    $$ROOT_DIR/cpp/utility/livestatefile.h \
+    $$ROOT_DIR/cpp/utility/virtualclock.h \
+    $$ROOT_DIR/cpp/utility/thresholdmonitor.h
+
+include($$ROOT_DIR/orgInfo.pri)
+include($$ROOT_DIR/appInfo.pri)
@@ -0,0 +1,97 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "fanout.h"
+
+#include <QElapsedTimer>
+
+#include "utility/helpers.h"
+
+FanOut::FanOut(Connection connection, int consumers, int ticks, QObject *parent)
+    : QObject(parent), m_connection(connection), m_consumerCount(consumers), m_tickCount(ticks),
+      m_clock(QDateTime(QDate(2017, 1, 2), QTime(0, 0))), m_timer(m_clock)
+{}
+
+void FanOut::run()
+{
+    connectConsumers();
+    m_timer.setObserved(this, true); // refreshed every second
+    m_timer.start(true);
+    m_timer.countWorkTime();
+    m_statistics = Statistics();
+
+    QElapsedTimer runTimer;
+    runTimer.start();
+
+    for (int i = 0; i < m_tickCount; ++i) {
+        m_clock.advance(1000);
+    }
+
+    m_statistics.runTime = runTimer.nsecsElapsed();
+    m_statistics.ticks = m_tickCount;
+    m_timer.stop();
+}
+
+const FanOut::Statistics &FanOut::statistics() const
+{
+    return m_statistics;
+}
+
+void FanOut::printSummary(QTextStream &stream) const
+{
+    const auto ticks = qMax(m_statistics.ticks, 1);
+
+    stream << (m_connection == Connection::Separate ? "Separate signals" : "Snapshot signal")
+           << " (" << m_consumerCount << " consumers, " << m_statistics.ticks << " ticks):\n"
+           << "  consumer calls:   " << m_statistics.evaluations << "\n"
+           << "  calls per tick:   " << QString::number(static_cast<double>(m_statistics.evaluations) / ticks, 'f', 2) << "\n"
+           << "  time per tick:    " << QString::number(m_statistics.runTime / 1000.0 / ticks, 'f', 3) << " us\n"
+           << "  run time:         " << QString::number(m_statistics.runTime / 1e9, 'f', 3) << " s\n";
+    stream.flush();
+}
+
+void FanOut::connectConsumers()
+{
+    for (int i = 0; i < m_consumerCount; ++i) {
+        if (m_connection == Connection::Separate) {
+            connect(&m_timer, &TimerController::elapsedWorkPeriodChanged, this, [this]() { updateToolTip(); });
+            connect(&m_timer, &TimerController::elapsedWorkTimeChanged, this, [this]() { updateToolTip(); });
+        } else {
+            connect(&m_timer, &TimerController::snapshotChanged, this, [this]() { updateToolTip(); });
+        }
+    }
+}
+
+void FanOut::updateToolTip()
+{
+    static const QString tooltipTemplate = QString("NEXT BREAK:\n"
+                                                   "%1 / %2\n"
+                                                   "\n"
+                                                   "WORK TIME:\n"
+                                                   "%3 / %4");
+    m_toolTip = tooltipTemplate
+            .arg(Helpers::formatTime(m_timer.elapsedWorkPeriod()))
+            .arg(Helpers::formatTime(sc_breakInterval))
+            .arg(Helpers::formatTime(m_timer.elapsedWorkTime()))
+            .arg(Helpers::formatTime(sc_workTime));
+    ++m_statistics.evaluations;
+}
@@ -0,0 +1,89 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <QObject>
+#include <QString>
+#include <QTextStream>
+
+#include "controller/timercontroller.h"
+#include "utility/virtualclock.h"
+
+/*!
+ * \brief Measures delivery of timer ticks to consumers of elapsed times.
+ *
+ * Each consumer rebuilds a tooltip like TrayManager does, connected
+ * either to the separate change signals of elapsed times (as consumers
+ * were before the snapshot signal) or to snapshotChanged().
+ * Work time is counted on a virtual clock, one tick a second.
+ */
+class FanOut final : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Connection : quint8 {
+        Separate,   //! to elapsedWorkPeriodChanged() and elapsedWorkTimeChanged()
+        Snapshot    //! to snapshotChanged()
+    };
+
+    /*!
+     * \brief Statistics gathered during benchmark.
+     */
+    struct Statistics {
+        int ticks = 0;
+        qint64 evaluations = 0; //! consumer calls
+        qint64 runTime = 0;     //! ns
+    };
+
+    /*!
+     * \param connection    how consumers are connected
+     * \param consumers     number of consumers
+     * \param ticks         number of timer ticks
+     * \param parent        a parent object
+     */
+    FanOut(Connection connection, int consumers, int ticks, QObject *parent = 0);
+
+    void run();
+
+    const Statistics &statistics() const;
+    void printSummary(QTextStream &stream) const;
+
+private:
+    static const int sc_breakInterval = 50*60;  //! s, shown by consumers
+    static const int sc_workTime = 8*60*60;     //! s, shown by consumers
+
+    const Connection m_connection;
+    const int m_consumerCount;
+    const int m_tickCount;
+
+    VirtualClock m_clock;
+    TimerController m_timer;
+    QString m_toolTip;  //! lastly built by a consumer
+    Statistics m_statistics;
+
+    void connectConsumers();
+    void updateToolTip();
+};
+
+#endif // FANOUT_H
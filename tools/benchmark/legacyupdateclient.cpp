@@ -0,0 +1,65 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "legacyupdateclient.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+LegacyUpdateClient::LegacyUpdateClient(const QUrl &versionUrl, Clock &clock, QObject *parent)
+    : QObject(parent), m_versionUrl(versionUrl),
+      m_nam(new QNetworkAccessManager(this)), m_retryTimer(clock)
+{
+    m_retryTimer.setSingleShot(true);
+    m_retryTimer.setInterval(sc_retryInterval);
+
+    connect(m_nam, &QNetworkAccessManager::finished,
+            this, &LegacyUpdateClient::onNetworkReply);
+    connect(&m_retryTimer, &ClockTimer::timeout,
+            this, &LegacyUpdateClient::getVersionResponse);
+}
+
+void LegacyUpdateClient::checkUpdateAvailable()
+{
+    m_retryCounter = 0;
+    getVersionResponse();
+}
+
+void LegacyUpdateClient::getVersionResponse()
+{
+    m_nam->get(QNetworkRequest(m_versionUrl));
+}
+
+void LegacyUpdateClient::onNetworkReply(QNetworkReply *reply)
+{
+    reply->deleteLater();
+
+    auto httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() == QNetworkReply::NoError && httpStatusCode == 200) {
+        emit checkFinished();
+    } else if (m_retryCounter++ < sc_retryMaxCount) {
+        m_retryTimer.start();
+    } else {
+        emit checkError();
+    }
+}
@@ -0,0 +1,67 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef LEGACYUPDATECLIENT_H
+#define LEGACYUPDATECLIENT_H
+
+#include <QObject>
+#include <QUrl>
+
+#include "utility/clock.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/*!
+ * \brief Model of update checks as they were before jittered backoff.
+ *
+ * Checks right after startup and retries a failed check every second,
+ * five times, with the network access manager kept for the whole
+ * session. Only requests are modelled, replies are not parsed.
+ */
+class LegacyUpdateClient final : public QObject
+{
+    Q_OBJECT
+public:
+    LegacyUpdateClient(const QUrl &versionUrl, Clock &clock, QObject *parent = 0);
+
+    void checkUpdateAvailable();
+
+signals:
+    void checkFinished() const;
+    void checkError() const;
+
+private:
+    static const int sc_retryInterval = 1000; // ms
+    static const int sc_retryMaxCount = 5;
+
+    const QUrl m_versionUrl;
+    QNetworkAccessManager *m_nam;
+    ClockTimer m_retryTimer;
+    int m_retryCounter = 0;
+
+private slots:
+    void getVersionResponse();
+    void onNetworkReply(QNetworkReply *reply);
+};
+
+#endif // LEGACYUPDATECLIENT_H
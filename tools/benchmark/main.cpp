@@ -0,0 +1,163 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QTextStream>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "fanout.h"
+#include "isolatedstorage.h"
+#include "settingsreads.h"
+#include "startup.h"
+#include "updateload.h"
+
+/*!
+ * \brief Allows as many open files as possible,
+ * each simulated client holds its own connection.
+ */
+static void raiseFileLimit()
+{
+#ifdef Q_OS_UNIX
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+}
+
+static int runUpdateLoad(int clients, int outage, QTextStream &out)
+{
+    raiseFileLimit();
+    QLoggingCategory::setFilterRules("default.warning=false"); // failed checks are expected
+
+    for (auto policy : { UpdateLoad::Policy::Legacy, UpdateLoad::Policy::Current }) {
+        UpdateLoad load(policy, clients, outage);
+        load.run();
+        load.printSummary(out);
+    }
+    return 0;
+}
+
+static int runFanOut(int consumers, int ticks, QTextStream &out)
+{
+    for (auto connection : { FanOut::Connection::Separate, FanOut::Connection::Snapshot }) {
+        FanOut fanOut(connection, consumers, ticks);
+        fanOut.run();
+        fanOut.printSummary(out);
+    }
+    return 0;
+}
+
+static int runSettingsReads(int reads, QTextStream &out)
+{
+    SettingsReads settingsReads(reads);
+    settingsReads.run();
+    settingsReads.printSummary(out);
+    return 0;
+}
+
+static int runStartup(int runs, const QString &settingsPath, QTextStream &out)
+{
+    Startup startup(runs, settingsPath);
+    if (!startup.run())
+        return 1;
+    startup.printSummary(out);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startTimer;   // startup of child processes is measured from here
+    startTimer.start();
+
+    QTextStream out(stdout);
+    if (argc == 3 && qstrcmp(argv[1], "startup-child") == 0) {
+        // with the application object of the application
+        return Startup::runChild(QString::fromLocal8Bit(argv[2]), startTimer, argc, argv, out);
+    }
+
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName(ORG_NAME);
+    app.setOrganizationDomain(ORG_DOMAIN);
+    app.setApplicationName(QString(APP_NAME) + "-benchmark");
+    app.setApplicationVersion(APP_VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures application logic and startup.\n\n"
+                                     "Benchmarks:\n"
+                                     "  fanout      delivery of timer ticks, separate signals and snapshot signal\n"
+                                     "  settings    reads of settings, cached and through QSettings\n"
+                                     "  startup     time to first frame and memory in child processes, settings backends and network stack\n"
+                                     "  updateload  peak request rate of update checks, before and after backoff");
+    parser.addHelpOption();
+    QCommandLineOption clientsOption("clients", "Number of simulated clients (updateload).", "count", "2000");
+    parser.addOption(clientsOption);
+    QCommandLineOption outageOption("outage", "Server outage after startup, in seconds (updateload).", "secs", "300");
+    parser.addOption(outageOption);
+    QCommandLineOption consumersOption("consumers", "Number of tick consumers (fanout).", "count", "10");
+    parser.addOption(consumersOption);
+    QCommandLineOption ticksOption("ticks", "Number of timer ticks (fanout).", "count", "86400");
+    parser.addOption(ticksOption);
+    QCommandLineOption readsOption("reads", "Number of reads of each setting (settings).", "count", "1000000");
+    parser.addOption(readsOption);
+    QCommandLineOption runsOption("runs", "Number of runs of each variant (startup).", "count", "20");
+    parser.addOption(runsOption);
+    parser.addPositionalArgument("benchmark", "Benchmark to run.");
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    const auto arguments = parser.positionalArguments();
+    if (arguments.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    IsolatedStorage storage;
+    if (!storage.isValid()) {
+        err << "Cannot create settings directory\n";
+        return 1;
+    }
+
+    const auto benchmark = arguments.first();
+    if (benchmark == "fanout") {
+        return runFanOut(parser.value(consumersOption).toInt(), parser.value(ticksOption).toInt(), out);
+    }
+    if (benchmark == "settings") {
+        return runSettingsReads(parser.value(readsOption).toInt(), out);
+    }
+    if (benchmark == "startup") {
+        return runStartup(parser.value(runsOption).toInt(), storage.settingsPath(), out);
+    }
+    if (benchmark == "updateload") {
+        return runUpdateLoad(parser.value(clientsOption).toInt(), parser.value(outageOption).toInt(), out);
+    }
+
+    err << "Unknown benchmark: " << benchmark << "\n";
+    return 1;
+}
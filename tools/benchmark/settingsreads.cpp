@@ -0,0 +1,97 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "settingsreads.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSettings>
+
+#include "controller/settingscontroller.h"
+#include "model/settingsschema.h"
+
+SettingsReads::SettingsReads(int reads)
+    : m_readCount(reads)
+{}
+
+void SettingsReads::run()
+{
+    m_statistics = Statistics();
+    m_statistics.reads = 2 * m_readCount;
+
+    {
+        // both paths read stored values, not defaults
+        QSettings settings(QSettings::UserScope, QCoreApplication::organizationName(), QCoreApplication::applicationName());
+        settings.setValue(Setting::BreakInterval::path(), 50*60);
+        settings.setValue(Setting::WorkTime::path(), 7*60*60);
+    }
+
+    readUncached();
+    readCached();
+}
+
+const SettingsReads::Statistics &SettingsReads::statistics() const
+{
+    return m_statistics;
+}
+
+void SettingsReads::printSummary(QTextStream &stream) const
+{
+    const auto reads = qMax(m_statistics.reads, 1);
+
+    stream << "Settings reads (" << m_statistics.reads << " reads):\n"
+           << "  QSettings:        " << QString::number(static_cast<double>(m_statistics.uncachedTime) / reads, 'f', 1) << " ns/read\n"
+           << "  cached:           " << QString::number(static_cast<double>(m_statistics.cachedTime) / reads, 'f', 1) << " ns/read\n";
+    stream.flush();
+}
+
+void SettingsReads::readCached()
+{
+    SettingsController controller;
+
+    QElapsedTimer timer;
+    timer.start();
+    volatile int sum = 0;   // keeps the reads
+    for (int i = 0; i < m_readCount; ++i) {
+        sum += controller.breakInterval();
+        sum += controller.workTime();
+    }
+    m_statistics.cachedTime = timer.nsecsElapsed();
+}
+
+void SettingsReads::readUncached()
+{
+    QSettings settings(QSettings::UserScope, QCoreApplication::organizationName(), QCoreApplication::applicationName());
+    // as passed to the former Settings::value(groupName, key, defaultValue)
+    const QString groupName = QLatin1String("logic");
+    const QString breakIntervalKey = QLatin1String("breakInterval");
+    const QString workTimeKey = QLatin1String("workTime");
+
+    QElapsedTimer timer;
+    timer.start();
+    volatile int sum = 0;   // keeps the reads
+    for (int i = 0; i < m_readCount; ++i) {
+        sum += settings.value(groupName + '/' + breakIntervalKey, 45*60).toInt();
+        sum += settings.value(groupName + '/' + workTimeKey, 8*60*60).toInt();
+    }
+    m_statistics.uncachedTime = timer.nsecsElapsed();
+}
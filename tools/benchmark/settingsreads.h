@@ -0,0 +1,66 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef SETTINGSREADS_H
+#define SETTINGSREADS_H
+
+#include <QTextStream>
+
+/*!
+ * \brief Measures reads of settings used on each timer tick.
+ *
+ * Compares typed cached reads of SettingsController with reads
+ * through QSettings by group and key, as Settings getters did
+ * before the cache. Break interval and work time are read
+ * alternately, both stored in the settings file.
+ */
+class SettingsReads final
+{
+public:
+    /*!
+     * \brief Statistics gathered during benchmark.
+     */
+    struct Statistics {
+        int reads = 0;
+        qint64 cachedTime = 0;      //! ns
+        qint64 uncachedTime = 0;    //! ns
+    };
+
+    /*!
+     * \param reads     number of reads of each setting
+     */
+    explicit SettingsReads(int reads);
+
+    void run();
+
+    const Statistics &statistics() const;
+    void printSummary(QTextStream &stream) const;
+
+private:
+    const int m_readCount;
+    Statistics m_statistics;
+
+    void readCached();
+    void readUncached();
+};
+
+#endif // SETTINGSREADS_H
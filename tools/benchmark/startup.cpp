@@ -0,0 +1,263 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "startup.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QFile>
+#include <QIcon>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQuickWindow>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+
+#include "legacyupdateclient.h"
+#include "controller/controller.h"
+#include "controller/settingscontroller.h"
+#include "model/settings.h"
+#include "view/traymanager.h"
+
+const char *Startup::sc_storageVariable = "RESTO_BENCHMARK_STORAGE";
+const char *Startup::sc_nameVariable = "RESTO_BENCHMARK_NAME";
+const char *Startup::sc_versionUrl = "http://127.0.0.1:9/version";
+
+Startup::Startup(int runs, const QString &settingsPath)
+    : m_runCount(runs), m_settingsPath(settingsPath)
+{}
+
+bool Startup::run()
+{
+    prepareSettings();
+
+    for (auto variant : variants()) {
+        Result result;
+        if (!runVariant(variant, result))
+            return false;
+        m_results.insert(variant, result);
+    }
+    return true;
+}
+
+const QMap<Startup::Variant, Startup::Result> &Startup::results() const
+{
+    return m_results;
+}
+
+void Startup::printSummary(QTextStream &stream) const
+{
+    stream << "Startup (" << m_runCount << " runs, medians):\n";
+    for (auto it = m_results.constBegin(); it != m_results.constEnd(); ++it) {
+        stream << "  " << variantDescription(it.key()).leftJustified(18)
+               << QString::number(it.value().time / 1e6, 'f', 3) << " ms";
+        if (it.value().residentMemory >= 0)
+            stream << ", " << it.value().residentMemory << " KiB resident";
+        stream << "\n";
+    }
+    stream.flush();
+}
+
+int Startup::runChild(const QString &name, const QElapsedTimer &startTimer, int &argc, char **argv,
+                      QTextStream &out)
+{
+    QApplication app(argc, argv);
+    app.setWindowIcon(QIcon(":/resources/images/app-logo.png"));
+    app.setOrganizationName(ORG_NAME);
+    app.setOrganizationDomain(ORG_DOMAIN);
+    app.setApplicationVersion(APP_VERSION);
+
+    // storage of the parent, see IsolatedStorage
+    const auto environment = QProcessEnvironment::systemEnvironment();
+    QStandardPaths::setTestModeEnabled(true);
+    app.setApplicationName(environment.value(sc_nameVariable));
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, environment.value(sc_storageVariable));
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, environment.value(sc_storageVariable));
+
+    const auto allVariants = variants();
+    const auto it = std::find_if(allVariants.begin(), allVariants.end(),
+                                 [&name](Variant variant) { return variantName(variant) == name; });
+    if (it == allVariants.end())
+        return 1;
+    const auto variant = *it;
+
+    QScopedPointer<LegacyUpdateClient> legacyUpdater;
+    if (variant == Variant::EagerNetwork) {
+        // what UpdateController did at its construction, with a member network manager
+        legacyUpdater.reset(new LegacyUpdateClient(QUrl(sc_versionUrl), Clock::system()));
+        legacyUpdater->checkUpdateAvailable();
+    }
+
+    // as in main() of the application, settings backend is chosen by the environment set by the parent
+    Controller controller;
+    qmlRegisterUncreatableType<Controller>("Resto.Types", 1, 0, "Controller", "Controller class");
+
+    QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("controller", &controller);
+    engine.rootContext()->setContextProperty("app", &app);
+
+    engine.load(QUrl(QStringLiteral("qrc:/qml/main.qml")));
+    const auto window = engine.rootObjects().isEmpty()
+            ? nullptr : qobject_cast<QQuickWindow*>(engine.rootObjects().first());
+    if (!window) {
+        qWarning() << "[Startup]" << "Cannot load main window";
+        return 1;
+    }
+
+    TrayManager tray(controller, window);
+
+    qint64 firstFrameTime = -1;
+    QObject::connect(window, &QQuickWindow::frameSwapped, &app, [&]() {
+        if (firstFrameTime < 0) {
+            firstFrameTime = startTimer.nsecsElapsed();
+            app.quit();
+        }
+    });
+    QTimer::singleShot(sc_childTimeout, &app, &QCoreApplication::quit);
+    app.exec();
+
+    if (firstFrameTime < 0) {
+        qWarning() << "[Startup]" << "No frame rendered";
+        return 1;
+    }
+    out << firstFrameTime << ' ' << residentMemory() << "\n";
+    out.flush();
+    return 0;
+}
+
+void Startup::prepareSettings()
+{
+    {
+        SettingsController settings;
+        settings.setBreakDuration(15*60);
+        settings.setBreakInterval(50*60);
+        settings.setWorkTime(7*60*60);
+        settings.setPostponeTime(10*60);
+        settings.setWindowPosition(QPoint(100, 100));
+        settings.setWindowSize(QSize(500, 300));
+        settings.setUpdateSeed(1);
+    } // written on destruction
+
+    {
+        // migrates INI settings to the binary file
+        Settings settings(QCoreApplication::organizationName(), QCoreApplication::applicationName(),
+                          Settings::Backend::Binary);
+    }
+}
+
+bool Startup::runVariant(Variant variant, Result &result)
+{
+    auto environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(sc_storageVariable, m_settingsPath);
+    environment.insert(sc_nameVariable, QCoreApplication::applicationName());
+    environment.remove("RESTO_SETTINGS_BACKEND");   // see SettingsController
+    if (variant == Variant::BinarySettings)
+        environment.insert("RESTO_SETTINGS_BACKEND", "binary");
+
+    QVector<qint64> times;
+    QVector<qint64> memories;
+    for (int run = 0; run <= m_runCount; ++run) {
+        QProcess process;
+        process.setProcessEnvironment(environment);
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(QCoreApplication::applicationFilePath(),
+                      QStringList() << "startup-child" << variantName(variant));
+        if (!process.waitForFinished(2*sc_childTimeout) || process.exitStatus() != QProcess::NormalExit
+                || process.exitCode() != 0) {
+            qWarning() << "[Startup]" << "Child failed:" << variantName(variant) << process.errorString();
+            return false;
+        }
+
+        const auto values = QString::fromLatin1(process.readAllStandardOutput()).split(' ');
+        if (values.size() != 2)
+            return false;
+        if (run == 0)
+            continue;   // warm-up
+        times << values.at(0).trimmed().toLongLong();
+        memories << values.at(1).trimmed().toLongLong();
+    }
+
+    if (times.isEmpty())
+        return false;
+    std::sort(times.begin(), times.end());
+    std::sort(memories.begin(), memories.end());
+    result.time = times.at(times.size() / 2);
+    result.residentMemory = memories.at(memories.size() / 2);
+    return true;
+}
+
+QList<Startup::Variant> Startup::variants()
+{
+    return QList<Variant>() << Variant::IniSettings << Variant::BinarySettings
+                            << Variant::EagerNetwork << Variant::LazyNetwork;
+}
+
+QString Startup::variantName(Variant variant)
+{
+    switch (variant) {
+    case Variant::IniSettings:
+        return "ini";
+    case Variant::BinarySettings:
+        return "binary";
+    case Variant::EagerNetwork:
+        return "eager";
+    case Variant::LazyNetwork:
+        return "lazy";
+    }
+    return QString();
+}
+
+QString Startup::variantDescription(Variant variant)
+{
+    switch (variant) {
+    case Variant::IniSettings:
+        return "INI settings:";
+    case Variant::BinarySettings:
+        return "binary settings:";
+    case Variant::EagerNetwork:
+        return "eager network:";
+    case Variant::LazyNetwork:
+        return "lazy network:";
+    }
+    return QString();
+}
+
+qint64 Startup::residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if (status.open(QFile::ReadOnly)) {
+        for (const auto &line : status.readAll().split('\n')) {
+            if (line.startsWith("VmRSS:"))
+                return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+#endif
+    return -1;
+}
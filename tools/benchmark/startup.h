@@ -0,0 +1,113 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QTextStream>
+
+/*!
+ * \brief Measures startup of the application until its first frame.
+ *
+ * Each run starts this benchmark again in a child process, which
+ * starts the application as its main() does, measures time from main()
+ * until the main window swaps its first frame and reports it with its
+ * resident memory. Children share settings prepared by the parent.
+ * Medians of the runs are reported, the first run of each variant warms
+ * up file caches and is not counted.
+ *
+ * Single instance check of the application is not done in children.
+ */
+class Startup final
+{
+public:
+    enum class Variant : quint8 {
+        IniSettings,
+        BinarySettings,
+        EagerNetwork,   //! as LazyNetwork, with network access manager created and update check sent before the window is loaded, as before
+        LazyNetwork     //! update check scheduled by the main window, network created later by UpdateController
+    };
+
+    /*!
+     * \brief Medians of measurements of a variant.
+     */
+    struct Result {
+        qint64 time = 0;            //! ns
+        qint64 residentMemory = -1; //! KiB, -1 if not known
+    };
+
+    /*!
+     * \param runs          number of runs of each variant
+     * \param settingsPath  directory of settings files of this process
+     */
+    Startup(int runs, const QString &settingsPath);
+
+    /*!
+     * \brief Runs all variants.
+     * \return false if a child process failed
+     */
+    bool run();
+
+    const QMap<Variant, Result> &results() const;
+    void printSummary(QTextStream &stream) const;
+
+    /*!
+     * \brief Starts the application as the variant in a child process
+     * and prints its measurements.
+     *
+     * No application object may exist yet, the child creates its own.
+     *
+     * \param name          name of the variant
+     * \param startTimer    timer started at the beginning of main()
+     * \param argc, argv    arguments of main()
+     * \param out           stream for measurements
+     */
+    static int runChild(const QString &name, const QElapsedTimer &startTimer, int &argc, char **argv,
+                        QTextStream &out);
+
+private:
+    static const int sc_childTimeout = 30*1000;    //! ms, longest wait for the first frame
+    static const char *sc_storageVariable;  //! settings directory passed to children
+    static const char *sc_nameVariable;     //! application name passed to children
+    static const char *sc_versionUrl;       //! refused on loopback, no name lookup or server needed
+
+    const int m_runCount;
+    const QString m_settingsPath;
+    QMap<Variant, Result> m_results;
+
+    /*!
+     * \brief Writes non-default settings and migrates them to the binary file.
+     */
+    void prepareSettings();
+    bool runVariant(Variant variant, Result &result);
+
+    static QList<Variant> variants();
+    static QString variantName(Variant variant);
+    static QString variantDescription(Variant variant);
+    static qint64 residentMemory();
+};
+
+#endif // STARTUP_H
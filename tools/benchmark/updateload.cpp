@@ -0,0 +1,210 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "updateload.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QNetworkReply>
+
+#include <random>
+
+#include "legacyupdateclient.h"
+#include "controller/settingscontroller.h"
+#include "controller/updatecontroller.h"
+
+UpdateLoad::UpdateLoad(Policy policy, int clients, int outage, QObject *parent)
+    : QObject(parent), m_policy(policy), m_clientCount(clients), m_outage(outage * 1000LL),
+      m_clock(QDateTime(QDate(2017, 1, 2), QTime(8, 0)))    // a monday morning
+{
+    m_server.setRecording(false);
+    m_server.setHandler([this](const HttpStandIn::Request &) {
+        HttpStandIn::Response response;
+        if (elapsed() < m_outage) {
+            response.status = 503;
+        } else {
+            response.headers << qMakePair(QByteArray("Content-Type"), QByteArray("application/json"));
+            response.body = QString("{\"version\": \"%1\"}").arg(QCoreApplication::applicationVersion()).toUtf8();
+        }
+        return response;
+    });
+}
+
+UpdateLoad::~UpdateLoad()
+{
+    qDeleteAll(m_clients);
+}
+
+void UpdateLoad::run()
+{
+    QElapsedTimer runTimer;
+    runTimer.start();
+
+    if (!m_server.listen()) {
+        qWarning() << "[UpdateLoad]" << "Cannot start server";
+        return;
+    }
+
+    createClients();
+    startClients();
+    drain();
+    countRequests();
+
+    while (m_reportedClients.size() < m_clientCount && elapsed() < sc_maxDuration) {
+        const auto remaining = m_clock.nextTimerRemaining();
+        m_clock.advance(sc_step);
+        if (remaining >= 0 && remaining <= sc_step) { // otherwise nothing has been sent
+            drain();
+            countRequests();
+        }
+    }
+
+    m_statistics.simulatedTime = elapsed();
+    m_statistics.runTime = runTimer.nsecsElapsed();
+    for (int second = 0; second < m_rates.size(); ++second) {
+        if (m_rates.at(second) > m_statistics.peakRate) {
+            m_statistics.peakRate = m_rates.at(second);
+            m_statistics.peakTime = second * 1000LL;
+        }
+    }
+}
+
+const UpdateLoad::Statistics &UpdateLoad::statistics() const
+{
+    return m_statistics;
+}
+
+void UpdateLoad::printSummary(QTextStream &stream) const
+{
+    const auto runSecs = m_statistics.runTime / 1e9;
+    const auto simulatedSecs = m_statistics.simulatedTime / 1000.0;
+
+    stream << (m_policy == Policy::Legacy ? "Before" : "After")
+           << " (" << m_clientCount << " clients, " << m_outage / 1000 << " s outage):\n"
+           << "  requests:         " << m_statistics.requests << "\n"
+           << "  peak rate:        " << m_statistics.peakRate << " requests/s"
+           << " at " << m_statistics.peakTime / 1000 << " s\n"
+           << "  checks finished:  " << m_statistics.checksFinished << "\n"
+           << "  checks failed:    " << m_statistics.checksFailed << "\n"
+           << "  simulated time:   " << QString::number(simulatedSecs, 'f', 0) << " s\n"
+           << "  run time:         " << QString::number(runSecs, 'f', 3) << " s\n";
+    stream.flush();
+}
+
+void UpdateLoad::createClients()
+{
+    const auto versionUrl = m_server.url("/version");
+
+    if (m_policy == Policy::Legacy) {
+        for (int i = 0; i < m_clientCount; ++i) {
+            auto client = new LegacyUpdateClient(versionUrl, m_clock);
+            connect(client, &LegacyUpdateClient::checkFinished, this, [this, client]() { onCheckDone(client, true); });
+            connect(client, &LegacyUpdateClient::checkError, this, [this, client]() { onCheckDone(client, false); });
+            m_clients << client;
+        }
+        return;
+    }
+
+    // settings are shared, each controller reads its own seed on construction
+    m_settings.reset(new SettingsController());
+    m_settings->setLastUpdateCheck(QDateTime());
+    std::mt19937 random(sc_seed);
+    for (int i = 0; i < m_clientCount; ++i) {
+        int seed = 0;
+        while (seed == 0)
+            seed = static_cast<int>(random());
+        m_settings->setUpdateSeed(seed);
+
+        auto client = new UpdateController(*m_settings, versionUrl, m_clock);
+        connect(client, &UpdateController::checkFinished, this, [this, client]() { onCheckDone(client, true); });
+        connect(client, &UpdateController::checkError, this, [this, client]() { onCheckDone(client, false); });
+        m_clients << client;
+    }
+}
+
+void UpdateLoad::startClients()
+{
+    m_startTime = m_clock.monotonicTime();
+    for (auto client : m_clients) {
+        if (m_policy == Policy::Legacy) {
+            static_cast<LegacyUpdateClient*>(client)->checkUpdateAvailable();
+        } else {
+            static_cast<UpdateController*>(client)->scheduleUpdateCheck();
+        }
+    }
+}
+
+void UpdateLoad::onCheckDone(QObject *client, bool success)
+{
+    if (m_reportedClients.contains(client))
+        return; // only the first check is counted
+
+    m_reportedClients.insert(client);
+    if (success) {
+        ++m_statistics.checksFinished;
+    } else {
+        ++m_statistics.checksFailed;
+    }
+}
+
+qint64 UpdateLoad::elapsed() const
+{
+    return m_clock.monotonicTime() - m_startTime;
+}
+
+bool UpdateLoad::isBusy() const
+{
+    for (auto client : m_clients) {
+        for (auto reply : client->findChildren<QNetworkReply*>()) {
+            if (!reply->isFinished())
+                return true;
+        }
+    }
+    return false;
+}
+
+void UpdateLoad::drain()
+{
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        // replies and network managers are deleted later, not by processEvents()
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    } while (isBusy() && timer.elapsed() < sc_drainTimeout);
+
+    if (timer.elapsed() >= sc_drainTimeout)
+        qCritical() << "[UpdateLoad]" << "Replies not finished at" << elapsed() / 1000 << "s";
+}
+
+void UpdateLoad::countRequests()
+{
+    const auto second = static_cast<int>(elapsed() / 1000);
+    if (m_rates.size() <= second)
+        m_rates.resize(second + 1);
+
+    const auto count = m_server.requestCount();
+    m_rates[second] += count - m_countedRequests;
+    m_statistics.requests += count - m_countedRequests;
+    m_countedRequests = count;
+}
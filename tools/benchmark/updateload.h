@@ -0,0 +1,119 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef UPDATELOAD_H
+#define UPDATELOAD_H
+
+#include <QObject>
+#include <QList>
+#include <QScopedPointer>
+#include <QSet>
+#include <QTextStream>
+#include <QVector>
+
+#include "httpstandin.h"
+#include "utility/virtualclock.h"
+
+class SettingsController;
+
+/*!
+ * \brief Simulates update checks of many installations started at once.
+ *
+ * All clients run in this process on a virtual clock against a local
+ * HTTP server, which answers 503 during an outage at the beginning.
+ * Requests are counted per second of virtual time until each client
+ * has finished or given up its first check.
+ */
+class UpdateLoad final : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Policy : quint8 {
+        Legacy,     //! check at startup, retries every second (LegacyUpdateClient)
+        Current     //! scheduled check, jittered backoff (UpdateController)
+    };
+
+    /*!
+     * \brief Statistics gathered during simulation.
+     */
+    struct Statistics {
+        int requests = 0;
+        int peakRate = 0;           //! requests in the busiest second
+        qint64 peakTime = 0;        //! ms of virtual time, start of the busiest second
+        int checksFinished = 0;     //! first checks succeeded
+        int checksFailed = 0;       //! first checks given up
+        qint64 simulatedTime = 0;   //! ms
+        qint64 runTime = 0;         //! ns
+    };
+
+    /*!
+     * \param policy    update check policy of clients
+     * \param clients   number of clients
+     * \param outage    duration of the server outage (in s)
+     * \param parent    a parent object
+     */
+    UpdateLoad(Policy policy, int clients, int outage, QObject *parent = 0);
+    ~UpdateLoad();
+
+    void run();
+
+    const Statistics &statistics() const;
+    void printSummary(QTextStream &stream) const;
+
+private:
+    static const int sc_step = 100;                         //! ms of virtual time
+    static const qint64 sc_maxDuration = 2*60*60*1000LL;    //! ms of virtual time
+    static const int sc_drainTimeout = 60*1000;             //! ms of real time
+    static const quint32 sc_seed = 1;   //! of update seeds, runs are repeatable
+
+    const Policy m_policy;
+    const int m_clientCount;
+    const qint64 m_outage;  //! ms
+
+    VirtualClock m_clock;
+    HttpStandIn m_server;
+    QScopedPointer<SettingsController> m_settings;
+    QList<QObject*> m_clients;
+    QSet<QObject*> m_reportedClients;   //! clients which finished or gave up their first check
+
+    qint64 m_startTime = 0; //! monotonic time of clients startup
+    int m_countedRequests = 0;
+    QVector<int> m_rates;   //! requests per second of virtual time
+    Statistics m_statistics;
+
+    void createClients();
+    void startClients();
+    void onCheckDone(QObject *client, bool success);
+
+    qint64 elapsed() const;
+    bool isBusy() const;
+    /*!
+     * \brief Processes events until replies of all clients are finished.
+     */
+    void drain();
+    /*!
+     * \brief Adds requests received since last call to current second.
+     */
+    void countRequests();
+};
+
+#endif // UPDATELOAD_H
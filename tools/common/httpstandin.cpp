@@ -0,0 +1,165 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "httpstandin.h"
+
+#include <QHostAddress>
+#include <QTcpSocket>
+
+HttpStandIn::HttpStandIn(QObject *parent)
+    : QObject(parent)
+{
+    m_handler = [](const Request &) { return Response(); };
+    connect(&m_server, &QTcpServer::newConnection, this, &HttpStandIn::onNewConnection);
+}
+
+bool HttpStandIn::listen()
+{
+    m_server.setMaxPendingConnections(1024); // whole fleet can connect at once
+    return m_server.listen(QHostAddress::LocalHost);
+}
+
+QUrl HttpStandIn::url(const QString &path) const
+{
+    return QUrl(QString("http://127.0.0.1:%1%2").arg(m_server.serverPort()).arg(path));
+}
+
+void HttpStandIn::setHandler(const Handler &handler)
+{
+    m_handler = handler;
+}
+
+void HttpStandIn::setRecording(bool recording)
+{
+    m_recording = recording;
+}
+
+int HttpStandIn::requestCount() const
+{
+    return m_requestCount;
+}
+
+const QList<HttpStandIn::Request> &HttpStandIn::requests() const
+{
+    return m_requests;
+}
+
+void HttpStandIn::clear()
+{
+    m_requestCount = 0;
+    m_requests.clear();
+}
+
+void HttpStandIn::respond(QTcpSocket *socket, const Request &request)
+{
+    const auto response = m_handler(request);
+
+    QByteArray data = "HTTP/1.1 " + QByteArray::number(response.status) + ' '
+            + reasonPhrase(response.status) + "\r\n";
+    for (const auto &header : response.headers)
+        data += header.first + ": " + header.second + "\r\n";
+    data += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n"
+            + "Connection: close\r\n\r\n";
+    data += (response.closeAfter >= 0) ? response.body.left(response.closeAfter) : response.body;
+
+    socket->write(data);
+    socket->disconnectFromHost(); // after all data is written
+}
+
+bool HttpStandIn::parseRequest(const QByteArray &data, Request &request)
+{
+    const auto lines = data.split('\n');
+    const auto requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3)
+        return false;
+
+    request.method = requestLine.at(0);
+    request.path = requestLine.at(1);
+    for (int i = 1; i < lines.size(); ++i) {
+        const auto line = lines.at(i).trimmed();
+        const auto separator = line.indexOf(':');
+        if (separator > 0)
+            request.headers.insert(line.left(separator).trimmed().toLower(), line.mid(separator + 1).trimmed());
+    }
+    return true;
+}
+
+QByteArray HttpStandIn::reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 404: return "Not Found";
+    case 410: return "Gone";
+    case 416: return "Range Not Satisfiable";
+    case 503: return "Service Unavailable";
+    default: return "Status";
+    }
+}
+
+void HttpStandIn::onNewConnection()
+{
+    while (auto socket = m_server.nextPendingConnection()) {
+        m_buffers.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, &HttpStandIn::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, &HttpStandIn::onDisconnected);
+    }
+}
+
+void HttpStandIn::onReadyRead()
+{
+    auto socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !m_buffers.contains(socket))
+        return; // already answered
+
+    auto &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+    const auto headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0)
+        return; // wait for the rest of headers
+
+    Request request;
+    const auto valid = parseRequest(buffer.left(headerEnd), request);
+    m_buffers.remove(socket); // requests have no body, connection is closed after response
+
+    if (!valid) {
+        socket->abort();
+        socket->deleteLater();
+        return;
+    }
+    ++m_requestCount;
+    if (m_recording)
+        m_requests.append(request);
+    respond(socket, request);
+}
+
+void HttpStandIn::onDisconnected()
+{
+    auto socket = qobject_cast<QTcpSocket*>(sender());
+    m_buffers.remove(socket);
+    socket->deleteLater();
+}
@@ -0,0 +1,106 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef HTTPSTANDIN_H
+#define HTTPSTANDIN_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QTcpServer>
+#include <QUrl>
+
+#include <functional>
+
+class QTcpSocket;
+
+/*!
+ * \brief Minimal HTTP server standing in for the update server.
+ *
+ * Listens on the loopback interface, answers each request with
+ * the response returned by the handler and closes the connection.
+ * Requests are counted and, unless disabled, recorded, so tools
+ * can check what the application has sent.
+ */
+class HttpStandIn final : public QObject
+{
+    Q_OBJECT
+public:
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QMap<QByteArray, QByteArray> headers;   //! by lower case name
+    };
+
+    struct Response {
+        int status = 200;
+        QList<QPair<QByteArray, QByteArray>> headers;
+        QByteArray body;
+        int closeAfter = -1;    //! bytes of body sent before connection is dropped, -1 to send all
+    };
+
+    using Handler = std::function<Response(const Request &request)>;
+
+    explicit HttpStandIn(QObject *parent = 0);
+
+    /*!
+     * \brief Starts listening on a free port of the loopback interface.
+     */
+    bool listen();
+    /*!
+     * \brief Returns url of given path on this server.
+     */
+    QUrl url(const QString &path) const;
+
+    void setHandler(const Handler &handler);
+    /*!
+     * \brief Enables keeping of received requests (enabled by default).
+     */
+    void setRecording(bool recording);
+
+    int requestCount() const;
+    const QList<Request> &requests() const;
+    void clear();
+
+private:
+    QTcpServer m_server;
+    Handler m_handler;
+    bool m_recording = true;
+    int m_requestCount = 0;
+    QList<Request> m_requests;
+    QHash<QTcpSocket*, QByteArray> m_buffers;  //! received data of incomplete requests
+
+    void respond(QTcpSocket *socket, const Request &request);
+
+    static bool parseRequest(const QByteArray &data, Request &request);
+    static QByteArray reasonPhrase(int status);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+};
+
+#endif // HTTPSTANDIN_H
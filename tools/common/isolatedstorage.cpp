@@ -0,0 +1,64 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "isolatedstorage.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QStringList>
+
+IsolatedStorage::IsolatedStorage()
+{
+    QStandardPaths::setTestModeEnabled(true); // never touch files of the installed application
+    QCoreApplication::setApplicationName(QString("%1-%2").arg(QCoreApplication::applicationName())
+                                         .arg(QCoreApplication::applicationPid()));
+
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_settingsDir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_settingsDir.path());
+}
+
+IsolatedStorage::~IsolatedStorage()
+{
+    auto paths = QStringList()
+            << QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+            << QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    const auto runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (!runtimeDir.isEmpty())
+        paths << QDir(runtimeDir).absoluteFilePath(QCoreApplication::applicationName());
+
+    for (const auto &path : paths) {
+        if (!path.isEmpty()) // QDir would use the working directory
+            QDir(path).removeRecursively();
+    }
+}
+
+bool IsolatedStorage::isValid() const
+{
+    return m_settingsDir.isValid();
+}
+
+QString IsolatedStorage::settingsPath() const
+{
+    return m_settingsDir.path();
+}
@@ -0,0 +1,56 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef ISOLATEDSTORAGE_H
+#define ISOLATEDSTORAGE_H
+
+#include <QTemporaryDir>
+
+/*!
+ * \brief Storage of a tool run kept apart from the installed application.
+ *
+ * Enables QStandardPaths test mode, makes the application name unique
+ * to the process and puts QSettings files in a temporary directory,
+ * so each run starts from default settings and parallel runs share
+ * no files. Data, cache and runtime directories of the run are
+ * removed on destruction.
+ *
+ * Has to be created after the application name is set
+ * and before anything is read from the storage.
+ */
+class IsolatedStorage final
+{
+public:
+    IsolatedStorage();
+    ~IsolatedStorage();
+
+    bool isValid() const;
+    /*!
+     * \brief Returns directory of settings files.
+     */
+    QString settingsPath() const;
+
+private:
+    QTemporaryDir m_settingsDir;
+};
+
+#endif // ISOLATEDSTORAGE_H
@@ -0,0 +1,73 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+
+#include "isolatedstorage.h"
+#include "scenario.h"
+#include "simulation.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName(ORG_NAME);
+    app.setOrganizationDomain(ORG_DOMAIN);
+    app.setApplicationName(QString(APP_NAME) + "-simulator");
+    app.setApplicationVersion(APP_VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulates work days described by a scenario file.");
+    parser.addHelpOption();
+    QCommandLineOption quietOption({ "q", "quiet" }, "Print only the summary.");
+    parser.addOption(quietOption);
+    parser.addPositionalArgument("scenario", "Scenario file.");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    // each run has its own settings, backups and saves, parallel runs do not share them
+    IsolatedStorage storage;
+    if (!storage.isValid()) {
+        err << "Cannot create settings directory\n";
+        return 1;
+    }
+
+    Scenario scenario;
+    QString error;
+    if (!scenario.load(parser.positionalArguments().first(), error)) {
+        err << "Cannot load scenario: " << error << "\n";
+        return 1;
+    }
+
+    Simulation simulation(scenario, parser.isSet(quietOption) ? nullptr : &out);
+    simulation.run();
+    simulation.printSummary(out);
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "scenario.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+
+bool Scenario::load(const QString &filePath, QString &error)
+{
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        error = file.errorString();
+        return false;
+    }
+
+    QTextStream stream(&file);
+    int lineNumber = 0;
+    while (!stream.atEnd()) {
+        ++lineNumber;
+        auto line = stream.readLine();
+        line = line.left(line.indexOf('#')).simplified();   // strip comments
+        if (line.isEmpty())
+            continue;
+
+        if (!parseLine(line.split(' '), error)) {
+            error = QString("line %1: %2").arg(lineNumber).arg(error);
+            return false;
+        }
+    }
+
+    std::stable_sort(m_actions.begin(), m_actions.end(), [](const Action &a1, const Action &a2) {
+        return a1.time < a2.time;
+    });
+    return true;
+}
+
+int Scenario::days() const
+{
+    return m_days;
+}
+
+const QMap<QString, int> &Scenario::settings() const
+{
+    return m_settings;
+}
+
+const QList<BreakRule> &Scenario::breakRules() const
+{
+    return m_breakRules;
+}
+
+Scenario::BreakPolicy Scenario::breakPolicy() const
+{
+    return m_breakPolicy;
+}
+
+int Scenario::postponeCount() const
+{
+    return m_postponeCount;
+}
+
+const QList<Scenario::Action> &Scenario::actions() const
+{
+    return m_actions;
+}
+
+QStringList Scenario::availableSettings()
+{
+    return { "breakDuration", "breakInterval", "postponeTime", "workTime" };
+}
+
+bool Scenario::parseLine(const QStringList &tokens, QString &error)
+{
+    const auto &directive = tokens.first();
+
+    if (directive == "days") {
+        bool ok = false;
+        m_days = tokens.value(1).toInt(&ok);
+        if (!ok || m_days < 1 || tokens.size() != 2) {
+            error = "expected: days <count>";
+            return false;
+        }
+    } else if (directive == "set") {
+        int value = 0;
+        if (tokens.size() != 3 || !availableSettings().contains(tokens.at(1))
+                || !parseDuration(tokens.at(2), value)) {
+            error = QString("expected: set <%1> <duration>").arg(availableSettings().join('|'));
+            return false;
+        }
+        m_settings.insert(tokens.at(1), value);
+    } else if (directive == "rule") {
+        BreakRule rule;
+        rule.name = tokens.value(1);
+        rule.postponeTime = 5*60; // same as default postpone time
+        if (tokens.size() < 4 || tokens.size() > 5
+                || !parseDuration(tokens.at(2), rule.interval) || rule.interval <= 0
+                || !parseDuration(tokens.at(3), rule.duration) || rule.duration <= 0
+                || (tokens.size() == 5 && !parseDuration(tokens.at(4), rule.postponeTime))) {
+            error = "expected: rule <name> <interval> <duration> [postpone]";
+            return false;
+        }
+        m_breakRules.append(rule);
+    } else if (directive == "breaks") {
+        const auto policy = tokens.value(1);
+        bool ok = true;
+        m_postponeCount = 0;
+        if (policy == "accept" && tokens.size() == 2) {
+            m_breakPolicy = BreakPolicy::Accept;
+        } else if (policy == "skip" && tokens.size() == 2) {
+            m_breakPolicy = BreakPolicy::Skip;
+        } else if (policy == "postpone" && tokens.size() == 3) {
+            m_breakPolicy = BreakPolicy::Accept;
+            m_postponeCount = tokens.at(2).toInt(&ok);
+            ok = ok && m_postponeCount >= 0;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            error = "expected: breaks accept|skip|postpone <count>";
+            return false;
+        }
+    } else if (directive == "at") {
+        static const QMap<QString, Action::Type> actionTypes = {
+            { "start", Action::Type::Start },
+            { "pause", Action::Type::Pause },
+            { "stop", Action::Type::Stop },
+            { "break", Action::Type::Break },
+            { "restart", Action::Type::Restart },
+            { "addTime", Action::Type::AddTime },
+            { "substractTime", Action::Type::SubstractTime },
+            { "sleep", Action::Type::Sleep },
+            { "save", Action::Type::Save },
+            { "restore", Action::Type::Restore }
+        };
+
+        Action action;
+        if (tokens.size() < 3 || !parseTimeOfDay(tokens.at(1), action.time)
+                || !actionTypes.contains(tokens.at(2))) {
+            error = QString("expected: at <hh:mm[:ss]> <%1> [value]").arg(QStringList(actionTypes.keys()).join('|'));
+            return false;
+        }
+        action.type = actionTypes.value(tokens.at(2));
+
+        bool ok = true;
+        switch (action.type) {
+        case Action::Type::AddTime:
+        case Action::Type::SubstractTime:
+            action.value = tokens.value(3).toInt(&ok);
+            ok = ok && tokens.size() == 4 && action.value > 0;
+            break;
+        case Action::Type::Sleep:
+            ok = tokens.size() == 4 && parseDuration(tokens.at(3), action.value);
+            break;
+        case Action::Type::Save:
+            action.name = tokens.value(3);
+            ok = tokens.size() == 4;
+            break;
+        case Action::Type::Restore:
+            action.name = tokens.value(3);
+            ok = tokens.size() == 3 || tokens.size() == 4;
+            break;
+        default:
+            ok = tokens.size() == 3;
+            break;
+        }
+        if (!ok) {
+            error = QString("invalid value of action: %1").arg(tokens.at(2));
+            return false;
+        }
+        m_actions.append(action);
+    } else {
+        error = QString("unknown directive: %1").arg(directive);
+        return false;
+    }
+
+    return true;
+}
+
+bool Scenario::parseDuration(const QString &text, int &duration)
+{
+    static const QMap<QChar, int> units = { { 's', 1 }, { 'm', 60 }, { 'h', 60*60 } };
+
+    auto number = text;
+    int multiplier = 1;
+    if (!text.isEmpty() && units.contains(text.at(text.size() - 1))) {
+        multiplier = units.value(text.at(text.size() - 1));
+        number.chop(1);
+    }
+
+    bool ok = false;
+    duration = number.toInt(&ok) * multiplier;
+    return ok && duration >= 0;
+}
+
+bool Scenario::parseTimeOfDay(const QString &text, int &time)
+{
+    const auto parts = text.split(':');
+    if (parts.size() < 2 || parts.size() > 3)
+        return false;
+
+    time = 0;
+    for (int i = 0; i < 3; ++i) {
+        bool ok = true;
+        const auto value = parts.value(i, "0").toInt(&ok);
+        if (!ok || value < 0 || (i > 0 && value > 59))
+            return false;
+        time = time*60 + value;
+    }
+    return time < 24*60*60;
+}
@@ -0,0 +1,122 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMap>
+
+#include "model/breakrule.h"
+
+/*!
+ * \brief Description of simulated work days.
+ *
+ * Scenario file is a plain text file with one directive per line.
+ * Everything after '#' is a comment.
+ *
+ *  days <count>                        number of simulated days
+ *  set <setting> <duration>            breakDuration, breakInterval,
+ *                                      postponeTime or workTime
+ *  rule <name> <interval> <duration> [postpone]
+ *                                      additional break rule
+ *  breaks accept                       break requests are accepted
+ *  breaks skip                         break requests are skipped
+ *  breaks postpone <count>             each break is postponed count times
+ *                                      and accepted afterwards
+ *  at <hh:mm[:ss]> <action> [value]    action done every day at given time
+ *
+ * Actions: start, pause, stop, break, restart (application is killed
+ * and run again), addTime <minutes>, substractTime <minutes>,
+ * sleep <duration> (system is suspended), save <slot> (state is saved
+ * to a named slot) and restore [slot] (state is restored from the slot,
+ * or the most recently saved one if no slot is given, and checked
+ * against the saved one).
+ *
+ * Durations are given in seconds or with a unit suffix: s, m or h.
+ * Settings not named by the scenario have their default values.
+ */
+class Scenario final
+{
+public:
+    enum class BreakPolicy : qint8
+    {
+        Accept,
+        Skip
+    };
+
+    struct Action {
+        enum class Type : qint8
+        {
+            Start,
+            Pause,
+            Stop,
+            Break,
+            Restart,
+            AddTime,
+            SubstractTime,
+            Sleep,
+            Save,
+            Restore
+        };
+
+        int time = 0;   //! time of the day (in secs)
+        Type type = Type::Start;
+        int value = 0;  //! action argument (minutes or secs)
+        QString name;   //! slot name of save and restore, empty for the latest slot
+    };
+
+    /*!
+     * \brief Loads scenario from a file.
+     *
+     * \param filePath  path to the scenario file
+     * \param error     description of the problem on failure
+     * \return true if scenario has been loaded
+     */
+    bool load(const QString &filePath, QString &error);
+
+    int days() const;
+    const QMap<QString, int> &settings() const;
+    const QList<BreakRule> &breakRules() const;
+    BreakPolicy breakPolicy() const;
+    int postponeCount() const;
+    const QList<Action> &actions() const;
+
+    static QStringList availableSettings();
+
+private:
+    int m_days = 1;
+    QMap<QString, int> m_settings;  //! setting name -> value (in secs)
+    QList<BreakRule> m_breakRules;
+    BreakPolicy m_breakPolicy = BreakPolicy::Accept;
+    int m_postponeCount = 0;
+    QList<Action> m_actions;    //! actions ordered by time
+
+    bool parseLine(const QStringList &tokens, QString &error);
+
+    static bool parseDuration(const QString &text, int &duration);
+    static bool parseTimeOfDay(const QString &text, int &time);
+};
+
+#endif // SCENARIO_H
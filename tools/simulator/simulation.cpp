@@ -0,0 +1,312 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include "simulation.h"
+
+#include <QElapsedTimer>
+
+#include "controller/controller.h"
+#include "utility/helpers.h"
+
+Simulation::Simulation(const Scenario &scenario, QTextStream *log, QObject *parent)
+    : QObject(parent), m_scenario(scenario), m_log(log),
+      m_clock(QDateTime(QDate(2017, 1, 2), QTime(0, 0))),   // a monday
+      m_startTime(m_clock.wallTime()), m_postponesLeft(scenario.postponeCount())
+{}
+
+Simulation::~Simulation()
+{}
+
+void Simulation::run()
+{
+    QElapsedTimer runTimer;
+    runTimer.start();
+
+    createController();
+    applySettings();
+
+    for (int day = 0; day < m_scenario.days(); ++day) {
+        const auto dayStart = m_startTime + day * sc_msecsPerDay;
+
+        for (const auto &action : m_scenario.actions()) {
+            advanceTo(dayStart + action.time * 1000LL);
+            applyAction(action);
+        }
+
+        advanceTo(dayStart + sc_msecsPerDay);
+        finishDay();
+    }
+
+    m_controller->clear();
+    m_controller.reset();
+
+    m_statistics.simulatedTime = m_clock.wallTime() - m_startTime;
+    m_statistics.runTime = runTimer.nsecsElapsed();
+}
+
+const Simulation::Statistics &Simulation::statistics() const
+{
+    return m_statistics;
+}
+
+void Simulation::printSummary(QTextStream &stream) const
+{
+    const auto breakSequences = m_statistics.breaksStarted + m_statistics.breaksSkipped;
+    const auto compliance = breakSequences ? 100.0 * m_statistics.breaksCompleted / breakSequences : 100.0;
+    const auto runSecs = m_statistics.runTime / 1e9;
+    const auto simulatedSecs = m_statistics.simulatedTime / 1000.0;
+
+    stream << "Summary:\n"
+           << "  break requests:   " << m_statistics.breakRequests << "\n"
+           << "  breaks started:   " << m_statistics.breaksStarted << "\n"
+           << "  breaks completed: " << m_statistics.breaksCompleted << "\n"
+           << "  breaks postponed: " << m_statistics.breaksPostponed << "\n"
+           << "  breaks skipped:   " << m_statistics.breaksSkipped << "\n"
+           << "  work ends:        " << m_statistics.workEnds << "\n"
+           << "  restarts:         " << m_statistics.restarts << "\n"
+           << "  slots saved:      " << m_statistics.slotsSaved << "\n"
+           << "  slots restored:   " << m_statistics.slotsRestored << "\n"
+           << "  slot errors:      " << m_statistics.slotErrors << "\n"
+           << "  compliance:       " << QString::number(compliance, 'f', 1) << " %\n"
+           << "  simulated time:   " << QString::number(simulatedSecs, 'f', 0) << " s\n"
+           << "  run time:         " << QString::number(runSecs, 'f', 3) << " s\n"
+           << "  throughput:       " << QString::number(runSecs > 0 ? simulatedSecs / runSecs : 0, 'f', 0)
+           << " simulated s/s\n";
+    stream.flush();
+}
+
+void Simulation::createController()
+{
+    m_controller.reset(new Controller(m_clock));
+
+    connect(m_controller.data(), &Controller::breakStartRequest, this, &Simulation::onBreakStartRequest);
+    connect(m_controller.data(), &Controller::breakEndRequest, this, &Simulation::onBreakEndRequest);
+    connect(m_controller.data(), &Controller::workEndRequest, this, &Simulation::onWorkEndRequest);
+}
+
+void Simulation::applySettings()
+{
+    auto &settings = m_controller->settings();
+    const auto &values = m_scenario.settings();
+
+    settings.beginTransaction();
+    settings.resetValues(); // settings not named by the scenario must not depend on previous runs
+    if (values.contains("breakDuration"))
+        settings.setBreakDuration(values.value("breakDuration"));
+    if (values.contains("breakInterval"))
+        settings.setBreakInterval(values.value("breakInterval"));
+    if (values.contains("postponeTime"))
+        settings.setPostponeTime(values.value("postponeTime"));
+    if (values.contains("workTime"))
+        settings.setWorkTime(values.value("workTime"));
+    settings.setBreakRules(m_scenario.breakRules());
+    settings.setAutoStart(false);
+    settings.commitTransaction();
+}
+
+void Simulation::applyAction(const Scenario::Action &action)
+{
+    switch (action.type) {
+    case Scenario::Action::Type::Start:
+        log("start");
+        m_controller->start();
+        break;
+    case Scenario::Action::Type::Pause:
+        log("pause");
+        m_controller->pause();
+        break;
+    case Scenario::Action::Type::Stop:
+        log("stop");
+        m_controller->stop();
+        break;
+    case Scenario::Action::Type::Break:
+        log("break taken manually");
+        ++m_statistics.breaksStarted;
+        m_controller->startBreak();
+        break;
+    case Scenario::Action::Type::Restart:
+    {
+        log("restart");
+        ++m_statistics.restarts;
+        const auto wasWorking = m_controller->isWorking();
+        m_controller.reset();   // killed, backup is not cleaned
+        createController();
+        if (wasWorking)
+            m_controller->start();
+        break;
+    }
+    case Scenario::Action::Type::AddTime:
+        log(QString("add %1 min").arg(action.value));
+        m_controller->timer().addTime(action.value);
+        break;
+    case Scenario::Action::Type::SubstractTime:
+        log(QString("substract %1 min").arg(action.value));
+        m_controller->timer().substractTime(action.value);
+        break;
+    case Scenario::Action::Type::Sleep:
+        log(QString("sleep for %1").arg(Helpers::formatTime(action.value)));
+        m_clock.sleep(action.value * 1000LL);
+        break;
+    case Scenario::Action::Type::Save:
+        saveSlot(action.name);
+        break;
+    case Scenario::Action::Type::Restore:
+        restoreSlot(action.name);
+        break;
+    default:
+        Q_ASSERT(false);
+    }
+}
+
+void Simulation::saveSlot(const QString &name)
+{
+    if (!m_controller->saveSlot(name)) {
+        log(QString("save to %1 failed").arg(name));
+        ++m_statistics.slotErrors;
+        m_savedSlots.remove(name);
+        return;
+    }
+    ++m_statistics.slotsSaved;
+    m_latestSlot = name;
+
+    // during break saved work times are not the displayed ones
+    if (m_controller->timer().activePeriodType() != TimerController::PeriodType::Work) {
+        log(QString("saved to %1 during break, restore is not checked").arg(name));
+        m_savedSlots.remove(name);
+        return;
+    }
+
+    BackupManager::Data data;
+    data.elapsedWorkPeriod = m_controller->timer().elapsedWorkPeriod();
+    data.elapsedWorkTime = m_controller->timer().elapsedWorkTime();
+    m_savedSlots.insert(name, data);
+    log(QString("saved to %1: work period %2, work time %3")
+        .arg(name)
+        .arg(Helpers::formatTime(data.elapsedWorkPeriod))
+        .arg(Helpers::formatTime(data.elapsedWorkTime)));
+}
+
+void Simulation::restoreSlot(const QString &slotName)
+{
+    const auto name = slotName.isEmpty() ? m_latestSlot : slotName;
+    const auto wasWorking = m_controller->isWorking();
+    const auto restored = slotName.isEmpty() ? m_controller->restoreLatestSlot()
+                                             : m_controller->restoreSlot(name);
+    if (!restored) {
+        log(QString("restore from %1 failed").arg(name));
+        ++m_statistics.slotErrors;
+        return;
+    }
+    ++m_statistics.slotsRestored;
+
+    BackupManager::Data data;
+    data.elapsedWorkPeriod = m_controller->timer().elapsedWorkPeriod();
+    data.elapsedWorkTime = m_controller->timer().elapsedWorkTime();
+    log(QString("restored from %1: work period %2, work time %3")
+        .arg(name)
+        .arg(Helpers::formatTime(data.elapsedWorkPeriod))
+        .arg(Helpers::formatTime(data.elapsedWorkTime)));
+    if (m_savedSlots.contains(name) && m_savedSlots.value(name) != data) {
+        log(QString("restored times differ from saved to %1").arg(name));
+        ++m_statistics.slotErrors;
+    }
+
+    if (wasWorking)
+        m_controller->start();
+}
+
+void Simulation::finishDay()
+{
+    switch (m_controller->state()) {
+    case Controller::State::Paused:
+        m_controller->start();
+        // fall through
+    case Controller::State::Working:
+        log("day finished while working");
+        m_controller->stop();
+        break;
+    default:
+        break;
+    }
+}
+
+void Simulation::advanceTo(qint64 wallTime)
+{
+    const auto remaining = wallTime - m_clock.wallTime();
+    if (remaining > 0)
+        m_clock.advance(remaining);
+}
+
+void Simulation::log(const QString &message)
+{
+    if (!m_log)
+        return;
+
+    const auto time = m_clock.wallTime() - m_startTime;
+    *m_log << QString("day %1 %2  %3\n")
+             .arg(time / sc_msecsPerDay + 1)
+             .arg(Helpers::formatTime(static_cast<int>((time % sc_msecsPerDay) / 1000)))
+             .arg(message);
+}
+
+void Simulation::onBreakStartRequest()
+{
+    ++m_statistics.breakRequests;
+
+    if (m_postponesLeft > 0) {
+        --m_postponesLeft;
+        ++m_statistics.breaksPostponed;
+        log("break requested: postponed");
+        m_controller->postponeBreak();
+        return;
+    }
+    m_postponesLeft = m_scenario.postponeCount();   // next break
+
+    switch (m_scenario.breakPolicy()) {
+    case Scenario::BreakPolicy::Accept:
+        log("break requested: started");
+        ++m_statistics.breaksStarted;
+        m_controller->startBreak();
+        break;
+    case Scenario::BreakPolicy::Skip:
+        log("break requested: skipped");
+        ++m_statistics.breaksSkipped;
+        m_controller->startWork();
+        break;
+    default:
+        Q_ASSERT(false);
+    }
+}
+
+void Simulation::onBreakEndRequest()
+{
+    log("break finished");
+    ++m_statistics.breaksCompleted;
+    m_controller->startWork();
+}
+
+void Simulation::onWorkEndRequest()
+{
+    log("work finished");
+    ++m_statistics.workEnds;
+    m_controller->stop();
+}
@@ -0,0 +1,114 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <QObject>
+#include <QMap>
+#include <QScopedPointer>
+#include <QTextStream>
+
+#include "scenario.h"
+#include "utility/virtualclock.h"
+#include "workers/backupmanager.h"
+
+class Controller;
+
+/*!
+ * \brief Runs a scenario on the application logic using virtual time.
+ *
+ * Simulated user answers requests of the controller
+ * according to the scenario break policy.
+ */
+class Simulation final : public QObject
+{
+    Q_OBJECT
+public:
+    /*!
+     * \brief Statistics gathered during simulation.
+     */
+    struct Statistics {
+        int breakRequests = 0;      //! all break requests, including repeated after postpone
+        int breaksStarted = 0;
+        int breaksCompleted = 0;    //! breaks lasting full break duration
+        int breaksPostponed = 0;
+        int breaksSkipped = 0;
+        int workEnds = 0;
+        int restarts = 0;
+        int slotsSaved = 0;
+        int slotsRestored = 0;
+        int slotErrors = 0;         //! failed saves and restores, restored times different from saved
+
+        qint64 simulatedTime = 0;   //! ms
+        qint64 runTime = 0;         //! ns
+    };
+
+    /*!
+     * \param scenario  scenario to simulate
+     * \param log       stream for simulation events, can be null
+     * \param parent    a parent object
+     */
+    Simulation(const Scenario &scenario, QTextStream *log, QObject *parent = 0);
+    ~Simulation();
+
+    void run();
+
+    const Statistics &statistics() const;
+    void printSummary(QTextStream &stream) const;
+
+private:
+    static const qint64 sc_msecsPerDay = 24*60*60*1000LL;
+
+    const Scenario &m_scenario;
+    QTextStream *m_log;
+
+    VirtualClock m_clock;
+    QScopedPointer<Controller> m_controller;
+
+    qint64 m_startTime;     //! wall time of simulation start (ms since epoch)
+    int m_postponesLeft;    //! postpones left for current break
+    QMap<QString, BackupManager::Data> m_savedSlots;  //! times saved to slots (by name)
+    QString m_latestSlot;   //! name of the most recently saved slot
+    Statistics m_statistics;
+
+    void createController();
+    void applySettings();
+    void applyAction(const Scenario::Action &action);
+    void saveSlot(const QString &name);
+    void restoreSlot(const QString &name);
+    void finishDay();
+
+    /*!
+     * \brief Advances virtual time up to the given wall time.
+     */
+    void advanceTo(qint64 wallTime);
+
+    void log(const QString &message);
+
+private slots:
+    void onBreakStartRequest();
+    void onBreakEndRequest();
+    void onWorkEndRequest();
+};
+
+#endif // SIMULATION_H
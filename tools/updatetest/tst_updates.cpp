@@ -0,0 +1,448 @@
+/********************************************
+**
+** Copyright 2017 JustCode Justyna Kulinska
+**
+** This file is part of Resto.
+**
+** Resto is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** any later version.
+**
+** Resto is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Resto; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+**
+********************************************/
+
+#include <QtTest>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "httpstandin.h"
+#include "controller/settingscontroller.h"
+#include "controller/updatecontroller.h"
+#include "workers/updatedownloader.h"
+#include "utility/virtualclock.h"
+
+/*!
+ * \brief Tests of update checks and downloads against a local HTTP server.
+ *
+ * Timers run on a virtual clock, which is advanced while waiting
+ * for replies, so retries and rate limiting take no real time.
+ */
+class UpdateTest final : public QObject
+{
+    Q_OBJECT
+public:
+    UpdateTest();
+
+private:
+    static const int sc_timeout = 10*1000;  //! ms of real time to wait for a signal
+    static const int sc_step = 100;         //! ms of virtual time advanced while waiting
+    static const QByteArray sc_lastModified;
+    static const int sc_packageSize = 300*1024;  //! bytes
+
+    VirtualClock m_clock;
+    HttpStandIn m_server;
+    QTemporaryDir m_settingsDir;
+    QScopedPointer<SettingsController> m_settings;
+
+    UpdateController *createUpdater();
+    /*!
+     * \brief Processes events and advances virtual time
+     * until the spy has count signals.
+     */
+    bool waitFor(QSignalSpy &spy, int count = 1);
+    QList<QByteArray> requestedPaths() const;
+
+    static HttpStandIn::Response manifestResponse(const QString &version);
+    static HttpStandIn::Response redirectResponse(int status, const QByteArray &location);
+    /*!
+     * \brief Returns package data, or its part requested with Range header.
+     */
+    static HttpStandIn::Response packageResponse(const QByteArray &package, const HttpStandIn::Request &request);
+    static QByteArray package();
+    static QByteArray sha256(const QByteArray &data);
+    static QByteArray readFile(const QString &fileName);
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void cleanupTestCase();
+
+    // version manifest cache
+    void notModified();
+    void newManifestReplacesValidators();
+    void redirect_data();
+    void redirect();
+    void redirectDroppedOnClientError();
+
+    // package download
+    void downloadResumed();
+    void downloadRestartedWithoutRange();
+    void downloadHashMismatch();
+};
+
+const QByteArray UpdateTest::sc_lastModified = "Mon, 02 Jan 2017 10:00:00 GMT";
+
+UpdateTest::UpdateTest()
+    : m_clock(QDateTime(QDate(2017, 1, 2), QTime(12, 0)))
+{}
+
+UpdateController *UpdateTest::createUpdater()
+{
+    return new UpdateController(*m_settings, m_server.url("/version"), m_clock);
+}
+
+bool UpdateTest::waitFor(QSignalSpy &spy, int count)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (spy.count() < count && timer.elapsed() < sc_timeout) {
+        QTest::qWait(1);
+        m_clock.advance(sc_step);
+    }
+    return spy.count() >= count;
+}
+
+QList<QByteArray> UpdateTest::requestedPaths() const
+{
+    QList<QByteArray> paths;
+    for (const auto &request : m_server.requests())
+        paths << request.path;
+    return paths;
+}
+
+HttpStandIn::Response UpdateTest::manifestResponse(const QString &version)
+{
+    HttpStandIn::Response response;
+    response.headers << qMakePair(QByteArray("Content-Type"), QByteArray("application/json"));
+    response.body = QString("{\"version\": \"%1\", \"releaseNotes\": \"notes\"}").arg(version).toUtf8();
+    return response;
+}
+
+HttpStandIn::Response UpdateTest::redirectResponse(int status, const QByteArray &location)
+{
+    HttpStandIn::Response response;
+    response.status = status;
+    response.headers << qMakePair(QByteArray("Location"), location);
+    return response;
+}
+
+HttpStandIn::Response UpdateTest::packageResponse(const QByteArray &package, const HttpStandIn::Request &request)
+{
+    HttpStandIn::Response response;
+    response.body = package;
+
+    static const QRegularExpression rangeRegExp("^bytes=(\\d+)-$");
+    const auto rangeMatch = rangeRegExp.match(QString::fromLatin1(request.headers.value("range")));
+    if (rangeMatch.hasMatch()) {
+        const auto offset = rangeMatch.captured(1).toInt();
+        response.status = 206;
+        response.headers << qMakePair(QByteArray("Content-Range"),
+                                      QString("bytes %1-%2/%3").arg(offset).arg(package.size() - 1)
+                                      .arg(package.size()).toLatin1());
+        response.body = package.mid(offset);
+    }
+    return response;
+}
+
+QByteArray UpdateTest::package()
+{
+    QByteArray data(sc_packageSize, Qt::Uninitialized);
+    for (int i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>((i * 131 + i / 4099) & 0xff);
+    return data;
+}
+
+QByteArray UpdateTest::sha256(const QByteArray &data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex();
+}
+
+QByteArray UpdateTest::readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+void UpdateTest::initTestCase()
+{
+    // nothing of the installed application is touched, parallel runs are separated
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication::setOrganizationName(ORG_NAME);
+    QCoreApplication::setApplicationName(QString("%1-updatetest-%2").arg(APP_NAME).arg(QCoreApplication::applicationPid()));
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QVERIFY(m_settingsDir.isValid());
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_settingsDir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_settingsDir.path());
+
+    QVERIFY(m_server.listen());
+}
+
+void UpdateTest::init()
+{
+    m_settings.reset(new SettingsController());
+    m_settings->resetValues();
+    m_server.clear();
+}
+
+void UpdateTest::cleanup()
+{
+    m_settings.reset();
+    QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).removeRecursively();
+}
+
+void UpdateTest::cleanupTestCase()
+{
+    QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).removeRecursively();
+}
+
+void UpdateTest::notModified()
+{
+    m_server.setHandler([](const HttpStandIn::Request &request) -> HttpStandIn::Response {
+        if (request.headers.value("if-none-match") == "\"v1\"") {
+            HttpStandIn::Response response;
+            response.status = 304;
+            return response;
+        }
+        auto response = manifestResponse("2.0.0");
+        response.headers << qMakePair(QByteArray("ETag"), QByteArray("\"v1\""))
+                         << qMakePair(QByteArray("Last-Modified"), sc_lastModified);
+        return response;
+    });
+
+    QScopedPointer<UpdateController> updater(createUpdater());
+    QSignalSpy finishedSpy(updater.data(), &UpdateController::checkFinished);
+    updater->checkUpdateAvailable();
+    QVERIFY(waitFor(finishedSpy));
+    QCOMPARE(updater->newestVersion(), QString("2.0.0"));
+
+    // validators and manifest are kept on disk for the next run
+    updater.reset(createUpdater());
+    QSignalSpy restartedSpy(updater.data(), &UpdateController::checkFinished);
+    updater->checkUpdateAvailable();
+    QVERIFY(waitFor(restartedSpy));
+
+    QCOMPARE(m_server.requestCount(), 2);
+    const auto &request = m_server.requests().last();
+    QCOMPARE(request.headers.value("if-none-match"), QByteArray("\"v1\""));
+    QCOMPARE(request.headers.value("if-modified-since"), sc_lastModified);
+    QCOMPARE(updater->newestVersion(), QString("2.0.0"));
+    QVERIFY(updater->updateAvailable());
+}
+
+void UpdateTest::newManifestReplacesValidators()
+{
+    int served = 0;
+    m_server.setHandler([&served](const HttpStandIn::Request &) -> HttpStandIn::Response {
+        auto response = manifestResponse(QString("2.0.%1").arg(served));
+        if (served == 0) {
+            response.headers << qMakePair(QByteArray("ETag"), QByteArray("\"v1\""))
+                             << qMakePair(QByteArray("Last-Modified"), sc_lastModified);
+        } else {
+            response.headers << qMakePair(QByteArray("ETag"), QByteArray("\"v2\""));
+        }
+        ++served;
+        return response;
+    });
+
+    QScopedPointer<UpdateController> updater(createUpdater());
+    QSignalSpy finishedSpy(updater.data(), &UpdateController::checkFinished);
+    for (int i = 1; i <= 3; ++i) {
+        updater->checkUpdateAvailable();
+        QVERIFY(waitFor(finishedSpy, i));
+    }
+
+    QCOMPARE(m_server.requestCount(), 3);
+    const auto &second = m_server.requests().at(1);
+    QCOMPARE(second.headers.value("if-none-match"), QByteArray("\"v1\""));
+    QCOMPARE(second.headers.value("if-modified-since"), sc_lastModified);
+    // Last-Modified of the first manifest does not describe the second one
+    const auto &third = m_server.requests().at(2);
+    QCOMPARE(third.headers.value("if-none-match"), QByteArray("\"v2\""));
+    QVERIFY(!third.headers.contains("if-modified-since"));
+    QCOMPARE(updater->newestVersion(), QString("2.0.2"));
+}
+
+void UpdateTest::redirect_data()
+{
+    QTest::addColumn<int>("status");
+    QTest::addColumn<bool>("persisted");
+
+    QTest::newRow("301") << 301 << true;
+    QTest::newRow("308") << 308 << true;
+    QTest::newRow("302") << 302 << false;
+    QTest::newRow("307") << 307 << false;
+}
+
+void UpdateTest::redirect()
+{
+    QFETCH(int, status);
+    QFETCH(bool, persisted);
+
+    m_server.setHandler([status](const HttpStandIn::Request &request) -> HttpStandIn::Response {
+        if (request.path == "/version")
+            return redirectResponse(status, "/moved/version");
+        return manifestResponse("2.0.0");
+    });
+
+    QScopedPointer<UpdateController> updater(createUpdater());
+    QSignalSpy finishedSpy(updater.data(), &UpdateController::checkFinished);
+    updater->checkUpdateAvailable();
+    QVERIFY(waitFor(finishedSpy));
+    QCOMPARE(requestedPaths(), QList<QByteArray>() << "/version" << "/moved/version");
+    QCOMPARE(updater->newestVersion(), QString("2.0.0"));
+
+    // permanent redirect target is requested directly by the next run
+    m_server.clear();
+    updater.reset(createUpdater());
+    QSignalSpy restartedSpy(updater.data(), &UpdateController::checkFinished);
+    updater->checkUpdateAvailable();
+    QVERIFY(waitFor(restartedSpy));
+    QCOMPARE(requestedPaths().first(), persisted ? QByteArray("/moved/version") : QByteArray("/version"));
+}
+
+void UpdateTest::redirectDroppedOnClientError()
+{
+    bool moved = true;
+    m_server.setHandler([&moved](const HttpStandIn::Request &request) -> HttpStandIn::Response {
+        if (request.path == "/version")
+            return moved ? redirectResponse(301, "/moved/version") : manifestResponse("2.0.0");
+        if (moved)
+            return manifestResponse("2.0.0");
+        HttpStandIn::Response response;
+        response.status = 404;
+        return response;
+    });
+
+    QScopedPointer<UpdateController> updater(createUpdater());
+    QSignalSpy finishedSpy(updater.data(), &UpdateController::checkFinished);
+    updater->checkUpdateAvailable();
+    QVERIFY(waitFor(finishedSpy));
+
+    // stored target is gone, the retry goes to the source url
+    moved = false;
+    m_server.clear();
+    updater.reset(createUpdater());
+    QSignalSpy restartedSpy(updater.data(), &UpdateController::checkFinished);
+    QSignalSpy errorSpy(updater.data(), &UpdateController::checkError);
+    updater->checkUpdateAvailable();
+    QVERIFY(waitFor(restartedSpy));
+    QCOMPARE(errorSpy.count(), 0);
+    QCOMPARE(requestedPaths(), QList<QByteArray>() << "/moved/version" << "/version");
+
+    // and it is not stored anymore
+    m_server.clear();
+    updater.reset(createUpdater());
+    QSignalSpy nextSpy(updater.data(), &UpdateController::checkFinished);
+    updater->checkUpdateAvailable();
+    QVERIFY(waitFor(nextSpy));
+    QCOMPARE(requestedPaths(), QList<QByteArray>() << "/version");
+}
+
+void UpdateTest::downloadResumed()
+{
+    const auto data = package();
+    m_server.setHandler([&data](const HttpStandIn::Request &request) -> HttpStandIn::Response {
+        auto response = packageResponse(data, request);
+        if (response.status == 200)
+            response.closeAfter = data.size() / 3; // connection lost
+        return response;
+    });
+
+    const auto url = m_server.url("/resto-setup.exe");
+    UpdateDownloader downloader(m_clock);
+    QSignalSpy finishedSpy(&downloader, &UpdateDownloader::finished);
+    QSignalSpy errorSpy(&downloader, &UpdateDownloader::error);
+    QSignalSpy progressSpy(&downloader, &UpdateDownloader::progress);
+
+    downloader.start(url, sha256(data));
+    QVERIFY(waitFor(errorSpy));
+    const auto partialSize = QFileInfo(downloader.filePath(url) + ".part").size();
+    QVERIFY(partialSize > 0);
+
+    // next start asks only for the rest of the package
+    progressSpy.clear();
+    downloader.start(url, sha256(data));
+    QVERIFY(waitFor(finishedSpy));
+    QCOMPARE(m_server.requestCount(), 2);
+    QCOMPARE(m_server.requests().last().headers.value("range"), QByteArray("bytes=" + QByteArray::number(partialSize) + "-"));
+    QCOMPARE(progressSpy.last().at(1).toLongLong(), qint64(data.size()));   // total from Content-Range
+
+    QCOMPARE(finishedSpy.first().first().toString(), downloader.filePath(url));
+    QVERIFY(readFile(downloader.filePath(url)) == data);
+    QVERIFY(!QFile::exists(downloader.filePath(url) + ".part"));
+}
+
+void UpdateTest::downloadRestartedWithoutRange()
+{
+    const auto data = package();
+    m_server.setHandler([&data](const HttpStandIn::Request &) -> HttpStandIn::Response {
+        HttpStandIn::Response response;    // Range is not supported
+        response.body = data;
+        return response;
+    });
+
+    const auto url = m_server.url("/resto-setup.exe");
+    UpdateDownloader downloader(m_clock);
+    const int rateLimit = 128*1024;
+    downloader.setRateLimit(rateLimit);
+
+    // stale partial file of some other package
+    QDir().mkpath(QFileInfo(downloader.filePath(url)).absolutePath());
+    QFile partial(downloader.filePath(url) + ".part");
+    QVERIFY(partial.open(QFile::WriteOnly));
+    partial.write(QByteArray(5000, 'x'));
+    partial.close();
+
+    QSignalSpy finishedSpy(&downloader, &UpdateDownloader::finished);
+    const auto startTime = m_clock.monotonicTime();
+    downloader.start(url, sha256(data));
+    QVERIFY(waitFor(finishedSpy));
+
+    QCOMPARE(m_server.requests().first().headers.value("range"), QByteArray("bytes=5000-"));
+    QVERIFY(readFile(downloader.filePath(url)) == data);
+    // rate is limited on the virtual clock, beyond the initial burst of 64 KiB
+    QVERIFY(m_clock.monotonicTime() - startTime >= (data.size() - 64*1024) * 1000LL / rateLimit);
+}
+
+void UpdateTest::downloadHashMismatch()
+{
+    const auto data = package();
+    m_server.setHandler([&data](const HttpStandIn::Request &request) -> HttpStandIn::Response {
+        return packageResponse(data, request);
+    });
+
+    const auto url = m_server.url("/resto-setup.exe");
+    UpdateDownloader downloader(m_clock);
+    QSignalSpy finishedSpy(&downloader, &UpdateDownloader::finished);
+    QSignalSpy errorSpy(&downloader, &UpdateDownloader::error);
+
+    downloader.start(url, sha256("some other package"));
+    QVERIFY(waitFor(errorSpy));
+    QCOMPARE(finishedSpy.count(), 0);
+    QVERIFY(!QFile::exists(downloader.filePath(url)));
+    QVERIFY(!QFile::exists(downloader.filePath(url) + ".part"));   // not resumed next time
+}
+
+QTEST_GUILESS_MAIN(UpdateTest)
+
+#include "tst_updates.moc"
@@ -0,0 +1,34 @@
+TEMPLATE = app
+TARGET = resto-updatetest
+
+QT += core gui network testlib
+QT -= qml quick widgets
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+ROOT_DIR = $$PWD/../..
+INCLUDEPATH += $$ROOT_DIR/cpp/ \
+    $$PWD/../common/
+
+SOURCES += tst_updates.cpp \
+    $$PWD/../common/httpstandin.cpp \
+    $$ROOT_DIR/cpp/model/settings.cpp \
+    $$ROOT_DIR/cpp/controller/settingscontroller.cpp \
+    $$ROOT_DIR/cpp/controller/updatecontroller.cpp \
+    $$ROOT_DIR/cpp/workers/updatedownloader.cpp \
+    $$ROOT_DIR/cpp/utility/clock.cpp \
+    $$ROOT_DIR/cpp/utility/virtualclock.cpp
+
+HEADERS += \
+    $$PWD/../common/httpstandin.h \
+    $$ROOT_DIR/cpp/model/settings.h \
+    $$ROOT_DIR/cpp/model/settingsschema.h \
+    $$ROOT_DIR/cpp/model/breakrule.h \
+    $$ROOT_DIR/cpp/controller/settingscontroller.h \
+    $$ROOT_DIR/cpp/controller/updatecontroller.h \
+    $$ROOT_DIR/cpp/workers/updatedownloader.h \
+    $$ROOT_DIR/cpp/utility/clock.h \
+    $$ROOT_DIR/cpp/utility/virtualclock.h
+
+include($$ROOT_DIR/orgInfo.pri)
+include($$ROOT_DIR/appInfo.pri)